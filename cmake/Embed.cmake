@@ -0,0 +1,23 @@
+# Writes INPUT into the C source OUTPUT as a byte array named NAME and its length as NAME_LENGTH, without INPUT
+# the array is empty. A zero follows the bytes, so no array is ever zero sized
+#   cmake -DNAME=RESOURCE_FONT -DINPUT=font.otf -DOUTPUT=font.c -P Embed.cmake
+
+if(INPUT)
+	file(READ ${INPUT} hex HEX)
+else()
+	set(hex "")
+endif()
+
+string(LENGTH "${hex}" hex_length)
+math(EXPR length "${hex_length} / 2")
+
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+
+# Regular expressions here have no counted repetition, so the one breaking lines after 16 bytes is spelled out
+set(row "")
+foreach(i RANGE 15)
+	string(APPEND row "0x[0-9a-f][0-9a-f],")
+endforeach()
+string(REGEX REPLACE "(${row})" "\\1\n\t" bytes "${bytes}")
+
+file(WRITE ${OUTPUT} "#include <stddef.h>\n\nconst unsigned char ${NAME}[] = {\n\t${bytes}0\n};\nconst size_t ${NAME}_LENGTH = ${length};\n")
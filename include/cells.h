@@ -1,25 +1,121 @@
 #pragma once
 
-#include "SDL2_gfxPrimitives.h"
+#include "gradient.h"
+#include "rule.h"
 
-typedef struct CellStruct {
-	Sint16 pos_x, pos_y;
-	int is_alive;
-	unsigned int alive_neighbours;
-	Uint8 r, g, b;
-} Cell;
+// Cells are packed 64 per word, bit (x % 64) of word (x / 64) in a row holds cell x
+typedef Uint64 CellsWord;
+
+#define CELLS_WORD_BITS 64
+
+// Activity is tracked in tiles of one word by this many rows, the step skips tiles whose neighbourhood didn't change
+#define CELLS_TILE_ROWS 64
+
+// Heat of a tile loses 1/2^CELLS_HEAT_SHIFT of itself every generation and gains CELLS_HEAT_UNIT when the tile
+// changes, so it follows how often the tile changed over roughly the last 2^CELLS_HEAT_SHIFT generations and
+// tops out at CELLS_HEAT_MAX for a tile changing every one of them
+#define CELLS_HEAT_SHIFT 6
+#define CELLS_HEAT_UNIT 512
+#define CELLS_HEAT_MAX (CELLS_HEAT_UNIT << CELLS_HEAT_SHIFT)
 
 typedef struct CellsGridStruct {
 	size_t width, height;
+	size_t words_per_row;  // stride of a packed row, unused bits of the last word are always 0
+	size_t tiles_x, tiles_y;
 	unsigned int cell_size;
-	Cell** cell;
+	Rule rule;
+	Uint64 generation;
+	Uint64 random_state;  // of the generator behind CellsGrid_randomize, part of the simulation state
+
+	CellsWord* cells;
+	void* mapping;  // file mapping the cells live in, NULL if they were allocated
+	size_t mapping_size;
+	char* mapping_path;  // of the mapped grid file, snapshots map it again. NULL if unknown
+
+	CellsWord* row_buffers;  // scratch rows for stepping in place
+	CellsWord* halo;  // unmodified row above every tile row, saved before stepping
+	size_t* spans;  // runs of active tiles in a tile row
+	Uint8* tile_active;  // has to be stepped next time
+	Uint8* tile_changed;  // changed since activity was last updated
+
+	// Every step and edit bumps the modification count and stamps the tiles it changed with it, so any number
+	// of observers can find tiles changed since they last looked by keeping the count they saw
+	Uint64 modification;
+	Uint64* tile_modification;
+	Uint64* tile_row_modification;  // newest stamp in every tile row, so rows nothing stamped can be skipped whole
+	size_t stepped_tiles;  // by the last step, the rest were skipped
+
+	Uint8* age;  // generations since last change per cell (y * width + x), NULL if age tracking is off
+	Uint64* age_generation;  // per tile, generation the stored ages are valid at
+
+	Uint16* tile_heat;  // decaying count of changes per tile, updated every generation, NULL if heat tracking is off
 } CellsGrid;
 
-// Constructor
-CellsGrid* CellsGrid_create(size_t width, size_t height, unsigned int cell_size);
+// Constructor, cells are randomized from the seed
+CellsGrid* CellsGrid_create(size_t width, size_t height, unsigned int cell_size, Uint64 seed);
+
+// Constructor taking ownership of already filled cells living in a file mapping (or allocated with malloc if
+// mapping is NULL), every tile starts out active
+CellsGrid* CellsGrid_create_mapped(size_t width, size_t height, unsigned int cell_size, CellsWord* cells, void* mapping, size_t mapping_size);
+
+// Constructor of a copy that can be drawn, saved and captured but not stepped or edited, as it has no step buffers.
+// Copies of a mapped grid share the file's pages nobody changed, copies of allocated ones only take memory for
+// the pages holding live cells. Returns NULL on failure
+CellsGrid* CellsGrid_create_snapshot(const CellsGrid* cells_grid);
+
+// Brings a snapshot up to date with the grid it was made from, copying only tiles stamped since its last update
+void CellsGrid_update_snapshot(CellsGrid* snapshot, const CellsGrid* cells_grid);
 
 // Destructor
 void CellsGrid_delete(CellsGrid* cells_grid);
 
-// Drawing
-void CellsGrid_draw(CellsGrid* cells_grid, SDL_Renderer* renderer, SDL_Rect* viewport, SDL_Texture* mesh_texture, int draw_mesh);
+// Allocates or frees the age plane, without it cells are drawn with the fully faded gradient colors
+int CellsGrid_set_age_tracking(CellsGrid* cells_grid, int enabled);
+
+// Allocates or frees the heat of tiles, it starts out cold and bumps the modification count
+int CellsGrid_set_heat_tracking(CellsGrid* cells_grid, int enabled);
+
+static inline CellsWord* CellsGrid_row(const CellsGrid* cells_grid, size_t y) {
+	return cells_grid->cells + y * cells_grid->words_per_row;
+}
+
+static inline int CellsGrid_get_cell(const CellsGrid* cells_grid, size_t x, size_t y) {
+	return (CellsGrid_row(cells_grid, y)[x / CELLS_WORD_BITS] >> (x % CELLS_WORD_BITS)) & 1;
+}
+
+static inline size_t CellsGrid_tile_index(const CellsGrid* cells_grid, size_t x, size_t y) {
+	return y / CELLS_TILE_ROWS * cells_grid->tiles_x + x / CELLS_WORD_BITS;
+}
+
+static inline Uint8 CellsGrid_get_age(const CellsGrid* cells_grid, size_t x, size_t y) {
+	if (cells_grid->age == NULL) {
+		return CELL_AGE_MAX;
+	}
+
+	// Ages of skipped tiles aren't touched, they just fall behind the current generation
+	Uint64 behind = cells_grid->generation - cells_grid->age_generation[CellsGrid_tile_index(cells_grid, x, y)];
+	Uint64 age = cells_grid->age[y * cells_grid->width + x] + behind;
+	return age < CELL_AGE_MAX ? age : CELL_AGE_MAX;
+}
+
+// Editing
+void CellsGrid_set_cell(CellsGrid* cells_grid, size_t x, size_t y, int is_alive);
+// Sets every cell within radius of a point on the line from (x0, y0) to (x1, y1), a stroke of disc shaped brush
+// dabs. Cells past the edges are skipped
+void CellsGrid_paint(CellsGrid* cells_grid, size_t x0, size_t y0, size_t x1, size_t y1, unsigned int radius, int is_alive);
+// Sets every cell of the rectangle, clipped to the grid
+void CellsGrid_fill(CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height, int is_alive);
+void CellsGrid_randomize(CellsGrid* cells_grid);  // also resets generation
+void CellsGrid_seed(CellsGrid* cells_grid, Uint64 seed);
+void CellsGrid_clear(CellsGrid* cells_grid);  // also resets generation
+void CellsGrid_set_generation(CellsGrid* cells_grid, Uint64 generation);
+
+// Has to be called after cells in the region were changed directly, so the step doesn't skip them
+void CellsGrid_touch(CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height);
+
+// Advances the grid by one generation
+void CellsGrid_step(CellsGrid* cells_grid);
+
+// Counts tiles touched since the last step or call as changed for a generation of heat, for generations that
+// don't come from stepping, like played back ones. They're already active, so they stop counting as changed
+void CellsGrid_update_heat(CellsGrid* cells_grid);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "cells.h"
+
+// Compressed copy of the full simulation state: cells, generation, rule, RNG state and ages. Every band of
+// CELLS_TILE_ROWS rows is compressed on its own, so capturing and restoring spread over all cores
+typedef struct CheckpointStruct {
+	Uint64 width, height;
+	Uint64 generation;
+	Uint64 random_state;
+	Rule rule;
+
+	size_t band_count;
+	Uint8** bands;  // compressed cells of each band, NULL where empty
+	Uint64* band_sizes;
+	Uint8** age_bands;  // NULL if ages aren't tracked
+	Uint64* age_band_sizes;
+	Uint64* age_generation;  // per tile, copied as is
+} Checkpoint;
+
+// Compresses the grid's state, the grid must not change until it returns. Returns NULL on failure
+Checkpoint* Checkpoint_capture(const CellsGrid* cells_grid);
+
+// Destructor
+void Checkpoint_delete(Checkpoint* checkpoint);
+
+// Writes to a temporary file next to path and renames it over path. Returns 0 on success
+int Checkpoint_write(const Checkpoint* checkpoint, const char* path);
+
+// Reads only the board dimensions from the header. Returns 0 on success
+int Checkpoint_peek(const char* path, size_t* width, size_t* height);
+
+// Restores a grid exactly as it was captured, age tracking included. Returns NULL on failure
+CellsGrid* Checkpoint_load(const char* path, unsigned int cell_size);
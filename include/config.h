@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SDL.h"
+#include "rule.h"
+
+#define CONFIG_PATH_MAX 512
+
+typedef struct ConfigStruct {
+	size_t grid_width, grid_height;
+	unsigned int cell_size;
+	int fade;  // age based coloring, costs a byte per cell
+	Rule rule;
+	char load_path[CONFIG_PATH_MAX];  // grid file or checkpoint loaded at startup instead of a random board, empty if none
+	char save_path[CONFIG_PATH_MAX];  // where the grid file is saved to
+	char pattern_path[CONFIG_PATH_MAX];  // RLE pattern placed on an empty board at startup, empty if none
+	int pattern_centered;
+	long long pattern_x, pattern_y;  // top left corner of the pattern if it's not centered
+	char export_path[CONFIG_PATH_MAX];  // where the board is exported to as RLE
+	char screenshot_path[CONFIG_PATH_MAX];  // where images of the board are saved to
+	char checkpoint_path[CONFIG_PATH_MAX];  // where checkpoints are written to
+	unsigned int checkpoint_interval;  // seconds between automatic checkpoints, 0 if off
+	size_t history_budget;  // megabytes of rewind history, 0 if off
+	char record_path[CONFIG_PATH_MAX];  // where every generation is recorded to, empty if not recording
+	char play_path[CONFIG_PATH_MAX];  // recording played back instead of simulating, empty if none
+	int seeded;  // random boards come from seed, otherwise from the time
+	Uint64 seed;
+	char video_path[CONFIG_PATH_MAX];  // renders a video without a window instead, empty if none
+	unsigned int video_frames;
+	unsigned int video_every;  // generations per frame
+	unsigned int brush_radius;  // cells painted around the one under the cursor, 0 for just that one
+	int verbose;  // logs timings such as how long startup took
+} Config;
+
+// Fills config with built-in defaults
+void Config_init(Config* config);
+
+// Reads "key = value" lines, '#' starts a comment. Returns 0 on success
+int Config_load_file(Config* config, const char* path);
+
+// Applies --config file first, then the remaining options on top of it.
+// Returns 0 to continue, 1 if usage was printed and -1 on invalid arguments
+int Config_parse_args(Config* config, int argc, char* argv[]);
+
+void Config_print_usage(const char* program_name);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "cells.h"
+
+// Side of the smallest blocks counted, in cells
+#define DENSITY_BASE_BLOCK 16
+
+// Live cell counts of square blocks of a grid, level k holding blocks of DENSITY_BASE_BLOCK << k cells a side,
+// up to a single block covering the grid. Blocks are recounted only in tiles stamped since the last update
+typedef struct DensityPyramidStruct {
+	int level_count;
+	size_t* widths;  // in blocks, per level
+	size_t* heights;
+	Uint32** counts;  // per level, row by row, saturating at SDL_MAX_UINT32
+	Uint64 modification;  // grid's as of the last update
+} DensityPyramid;
+
+// Constructor, counts the whole grid. Returns NULL on failure
+DensityPyramid* DensityPyramid_create(const CellsGrid* cells_grid);
+
+// Destructor
+void DensityPyramid_delete(DensityPyramid* pyramid);
+
+// Recounts the blocks of tiles changed since the last update and the blocks above them
+void DensityPyramid_update(DensityPyramid* pyramid, const CellsGrid* cells_grid);
+
+static inline Uint32 DensityPyramid_count(const DensityPyramid* pyramid, int level, size_t x, size_t y) {
+	return pyramid->counts[level][y * pyramid->widths[level] + x];
+}
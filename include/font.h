@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../lib/SDL_FontCache.h"
+
+#define FONT_SIZE 26
+
+// Baked by tools/bake_font.c at build time and embedded with the font itself
+#define FONT_ATLAS_MAGIC "GOLFONT"
+#define FONT_ATLAS_VERSION 1
+#define FONT_ATLAS_BYTE_ORDER 0x01020304  // reads differently on a host of the other endianness
+
+// Printable ASCII, all the HUD ever draws
+#define FONT_ATLAS_FIRST ' '
+#define FONT_ATLAS_LAST '~'
+#define FONT_ATLAS_GLYPHS (FONT_ATLAS_LAST - FONT_ATLAS_FIRST + 1)
+
+// Font metrics as SDL_FontCache keeps them, followed by a BMP of the glyphs. Written as is, every field is
+// naturally aligned so there is no padding
+typedef struct FontAtlasHeaderStruct {
+	char magic[8];
+	Uint32 version;
+	Uint32 byte_order;
+	Uint32 size;  // points the glyphs were rasterized at
+	Sint32 height, ascent, descent;
+	SDL_Rect glyphs[FONT_ATLAS_GLYPHS];  // in the image, empty for glyphs the font lacks
+} FontAtlasHeader;
+
+// Reads an atlas without rasterizing anything. Returns NULL if it's invalid or was baked at another size
+FC_Font* Font_load_atlas(SDL_Renderer* renderer, SDL_RWops* rw);
+
+// Loads the embedded atlas, rasterizes the embedded font if the build couldn't bake one. Returns NULL on failure
+FC_Font* Font_load(SDL_Renderer* renderer);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "SDL.h"
+
+// Highest value of the saturating "generations since last change" counter
+#define CELL_AGE_MAX 255
+
+typedef struct GradientStruct {
+	const char* name;
+	SDL_Color alive[CELL_AGE_MAX + 1];
+	SDL_Color dead[CELL_AGE_MAX + 1];
+} Gradient;
+
+enum Gradients {
+	GRADIENT_CLASSIC,  // the white flash fading to blue (alive) or black (dead)
+	GRADIENT_MONO,
+	GRADIENT_HEAT,
+	GRADIENTS_COUNT
+};
+
+// Returns built-in gradient, the lookup tables are built on the first call
+const Gradient* Gradient_get(enum Gradients index);
+
+static inline SDL_Color Gradient_color(const Gradient* gradient, int is_alive, Uint8 age) {
+	return is_alive ? gradient->alive[age] : gradient->dead[age];
+}
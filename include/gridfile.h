@@ -0,0 +1,23 @@
+#pragma once
+
+#include "cells.h"
+
+// Files start with a header page, followed by the tile activity map and the packed rows exactly as they are
+// laid out in memory, both starting on a page boundary
+#define GRID_FILE_PAGE_SIZE 4096
+
+// Writes the grid to a temporary file next to path and renames it over path. Returns 0 on success
+int GridFile_save(const CellsGrid* cells_grid, const char* path);
+
+// Reads only the board dimensions from the header. Returns 0 on success
+int GridFile_peek(const char* path, size_t* width, size_t* height);
+
+// Maps the file copy-on-write and wraps it in a grid without reading the cells, pages are faulted in lazily
+// as the step reaches active tiles and changes never go back to the file
+CellsGrid* GridFile_map(const char* path, unsigned int cell_size);
+
+void GridFile_unmap(void* mapping, size_t size);
+
+// Maps a mapped grid's file once more, copy-on-write, so the pages nothing changed are shared. Returns NULL if it
+// can't or the file was replaced since
+void* GridFile_map_again(const CellsGrid* cells_grid, size_t* size);
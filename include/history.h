@@ -0,0 +1,48 @@
+#pragma once
+
+#include "cells.h"
+
+// State of the grid after an edit or every few steps. Every entry holds the XOR against the previous one for the
+// tiles that changed, every so often an entry also holds the whole grid so old states can be rebuilt going
+// forward. Both live in the arena, at offsets in the order the entries were recorded
+typedef struct HistoryEntryStruct {
+	Uint64 generation;
+	size_t delta_offset, delta_size;  // per changed tile: index gap, mask of changed rows, then their XORs
+	size_t keyframe_offset, keyframe_size;  // run-length coded grid (raw if that isn't smaller), 0 size if none
+} HistoryEntry;
+
+// Bounded history of a grid. Entry data goes into a ring arena of the budget's size and the oldest entries are
+// dropped to make room, so recording never allocates
+typedef struct HistoryStruct {
+	HistoryEntry* entries;  // ring buffer
+	size_t first, count, capacity;
+
+	Uint8* arena;
+	size_t arena_size;
+	size_t head;  // where the next entry's data goes
+
+	CellsWord* shadow;  // grid as of the newest entry
+	CellsWord* run_xors;  // scratch of recording, a tile row's worth
+	Uint64 modification;  // grid's modification count the shadow matches
+	size_t deltas_since_keyframe;  // bytes
+	size_t last_keyframe_size;
+	size_t entries_since_keyframe;
+	size_t words_since_keyframe;  // walked by the deltas
+} History;
+
+// Constructor, the current state of the grid becomes the first entry. Returns NULL on failure
+History* History_create(const CellsGrid* cells_grid, size_t budget);
+
+// Destructor
+void History_delete(History* history);
+
+// Adds an entry if the grid changed since the last one. Cost is proportional to the tiles changed since
+int History_record(History* history, const CellsGrid* cells_grid);
+
+// Adds an entry after a step, but only every few generations. The grid must be recorded with History_record
+// before it's edited, so edits can be undone exactly
+int History_record_step(History* history, const CellsGrid* cells_grid);
+
+// Brings the grid back by up to steps generations or edits and drops the entries after it, stepping the grid
+// again through generations that weren't recorded. Returns how many it went back
+size_t History_rewind(History* history, CellsGrid* cells_grid, size_t steps);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../lib/SDL_FontCache.h"
+
+#define HUD_MAX_LINES 8
+#define HUD_LINE_LENGTH 64  // bytes of a line kept, longer ones are cut
+
+// Glyph cache textures the HUD draws from, glyphs the font put past them are skipped. Its ASCII fits in the first
+#define HUD_MAX_CACHE_LEVELS 4
+
+// Lines of text drawn straight from the font's glyph cache. Every line keeps its text and the quads of its
+// glyphs, laid out again only when the text changes, and the whole HUD goes out in one geometry call per glyph
+// cache texture. A line that changes every frame costs a layout of its few glyphs, the others nothing
+typedef struct HudStruct {
+	FC_Font* font;
+	float x, y;  // top left corner of the first line
+
+	int line_count;
+	char lines[HUD_MAX_LINES][HUD_LINE_LENGTH];
+	int glyph_counts[HUD_MAX_LINES];
+	int cache_levels[HUD_MAX_LINES][HUD_LINE_LENGTH];  // per glyph
+	SDL_Vertex vertices[HUD_MAX_LINES][HUD_LINE_LENGTH * 4];  // a quad per glyph
+
+	// Triangles of every glyph grouped by cache level, rebuilt when a line was laid out again
+	int indices[HUD_MAX_LINES * HUD_LINE_LENGTH * 6];
+	int index_counts[HUD_MAX_CACHE_LEVELS];
+	int indices_stale;
+} Hud;
+
+void Hud_init(Hud* hud, FC_Font* font, float x, float y);
+
+// Formats the line, which is laid out again only if it reads differently than before
+void Hud_set_line(Hud* hud, int line, const char* format, ...);
+
+// Lines past the count aren't drawn, setting one of them brings them back up to it
+void Hud_set_line_count(Hud* hud, int line_count);
+
+void Hud_draw(Hud* hud, SDL_Renderer* renderer);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "quadtree.h"
+
+// Reads a pattern in Golly's macrocell format ("[M2]" header, "#R" rule and "#G" generation lines, then one
+// line per distinct node: 8x8 leaves as rows of '.'/'*' ended by '$', higher nodes as "level nw ne sw se"
+// with 1-based indices of earlier lines and 0 for empty). The last node is the root. Returns NULL on failure
+QuadTree* Macrocell_load(const char* path);
+
+// Writes every distinct node of the tree once, children before their parents
+int Macrocell_save(const QuadTree* quadtree, const char* path);
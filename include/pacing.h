@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SDL.h"
+
+// Used when the display doesn't tell its refresh rate
+#define PACING_DEFAULT_REFRESH_RATE 60
+
+// Frames the percentiles are taken over
+#define PACING_HISTORY_LENGTH 256
+
+// Paces and measures frames on the performance counter. With vsync presenting already waits for the display,
+// otherwise frames are spaced at the refresh rate by sleeping until each one's deadline. Either way the only
+// wait is right before input is polled, so a frame is always built from the freshest input
+typedef struct FramePacerStruct {
+	Uint64 frequency;
+	Uint64 period;  // counter ticks per frame, 0 if presenting waits for vsync
+	Uint64 deadline;  // of the next frame
+	Uint64 last_frame;
+	int resumed;  // idled since the last frame, the next one isn't measured
+
+	// Frame times of the second being measured, in counter ticks
+	Uint64 window_start;
+	unsigned int frames;
+	double sum, sum_squares;
+	Uint64 longest;
+
+	// Ring of the latest frame times, in counter ticks
+	Uint64 history[PACING_HISTORY_LENGTH];
+	unsigned int history_next, history_count;
+
+	// Of the last whole second, times in milliseconds
+	double fps;
+	double frame_time;
+	double jitter;  // standard deviation of the frame time
+	double longest_time;
+	double frame_time_p50, frame_time_p99;  // over the frames in history
+} FramePacer;
+
+void FramePacer_init(FramePacer* pacer, int refresh_rate, int vsync);
+
+// Sleeps until the next frame is due, returns right away if vsync paces frames
+void FramePacer_wait(FramePacer* pacer);
+
+// Records a presented frame
+void FramePacer_presented(FramePacer* pacer);
+
+// Leaves time spent idle out of the frame times and the second being measured. The frame after it isn't held
+// back for pacing, nor measured as it doesn't follow a frame
+void FramePacer_idled(FramePacer* pacer);
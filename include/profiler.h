@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SDL.h"
+#include "simulation.h"
+
+enum ProfilerPhases {
+	PROFILER_EVENTS,  // input, commands and checkpoints
+	PROFILER_COLORS,  // recoloring and uploading the view's texture
+	PROFILER_RENDER,
+	PROFILER_PRESENT,
+	PROFILER_PHASES_COUNT
+};
+
+// Splits frames into phases timed on the performance counter and sets them beside what the simulation thread
+// measured over the same second, so a slow session shows where its time goes
+typedef struct ProfilerStruct {
+	Uint64 frequency;
+	Uint64 lap_start;
+
+	// Of the second being measured
+	Uint64 window_start;
+	unsigned int frames;
+	Uint64 sums[PROFILER_PHASES_COUNT];
+	SimulationStats window_stats;  // simulation's totals as the second started
+
+	// Of the last whole second
+	double phase_times[PROFILER_PHASES_COUNT];  // milliseconds per frame
+	double generations_per_second;
+	double cells_per_second;
+	double step_time;  // milliseconds per generation
+	double step_load;  // fraction of the second the simulation thread spent stepping
+} Profiler;
+
+void Profiler_init(Profiler* profiler);
+
+// Counter ticks since the previous lap
+Uint64 Profiler_lap(Profiler* profiler);
+
+void Profiler_add(Profiler* profiler, enum ProfilerPhases phase, Uint64 ticks);
+
+// Ends a frame, stats are the simulation's totals as of the generation it showed
+void Profiler_frame(Profiler* profiler, const SimulationStats* stats);
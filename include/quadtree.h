@@ -0,0 +1,50 @@
+#pragma once
+
+#include "cells.h"
+
+// Level of leaf nodes, they hold 8x8 cells as a byte per row (bit x of byte y is cell (x, y))
+#define QUADTREE_LEAF_LEVEL 3
+
+// Index of the empty node, it stands for an empty square of any level
+#define QUADTREE_EMPTY 0
+
+typedef struct QuadNodeStruct {
+	Uint32 level;
+	Uint32 child[4];  // nw, ne, sw, se, unused by leaves
+	Uint64 leaf;
+} QuadNode;
+
+// Hash-consed quadtree: equal subtrees are stored once, so memory scales with the number of distinct nodes
+// rather than with the area they cover
+typedef struct QuadTreeStruct {
+	QuadNode* nodes;
+	size_t node_count, node_capacity;
+	Uint32* table;  // open addressing hash table of node indices, 0 marks a free slot
+	size_t table_capacity;
+	Uint32 root;
+	Uint32 root_level;
+	Rule rule;
+	Uint64 generation;
+} QuadTree;
+
+// Constructor
+QuadTree* QuadTree_create(void);
+
+// Destructor
+void QuadTree_delete(QuadTree* quadtree);
+
+// Return index of the canonical node with given contents, creating it if it doesn't exist yet.
+// QUADTREE_EMPTY is returned for empty contents and 0xffffffff if memory ran out.
+Uint32 QuadTree_leaf(QuadTree* quadtree, Uint64 cells);
+Uint32 QuadTree_node(QuadTree* quadtree, Uint32 level, Uint32 nw, Uint32 ne, Uint32 sw, Uint32 se);
+
+// Builds a tree of the whole grid, 8x8 blocks are read straight from the packed rows. Returns NULL on failure
+QuadTree* QuadTree_from_grid(const CellsGrid* cells_grid);
+
+// Bounding box of alive cells relative to the root's top left corner, returns -1 if the tree is empty or too
+// big for 64-bit coordinates
+int QuadTree_bounds(const QuadTree* quadtree, Sint64* x, Sint64* y, Sint64* width, Sint64* height);
+
+// Sets alive cells of the tree in the grid, either with the bounding box centered or its top left corner at
+// (x, y). Fails if the pattern doesn't fit, the rule and generation of the tree are taken over
+int QuadTree_flatten(const QuadTree* quadtree, CellsGrid* cells_grid, int centered, long long x, long long y);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "cells.h"
+
+// Recordings are an append-only stream of one record per generation: a keyframe of the whole board every so
+// often and after every discontinuity (rewinds, restarts), otherwise the runs of cells born and died since the
+// previous generation. Closing the stream appends an index of the keyframes for seeking
+
+// Keyframe in a recording, with the generation the records following it reach before the next one
+typedef struct RecordingKeyframeStruct {
+	Uint64 generation, last_generation;
+	Uint64 offset;
+} RecordingKeyframe;
+
+// Appends the generations of a grid to a recording. Records are written to the active block while a background
+// thread writes the other one, stepping only waits if the disk falls a whole block behind
+typedef struct RecorderStruct {
+	FILE* file;
+	SDL_Thread* thread;
+	SDL_mutex* lock;
+	SDL_cond* block_ready;  // signalled when a block is handed over, and when it's been written
+	Uint8* blocks[2];
+	size_t block_capacities[2];
+	int active;  // block being filled
+	size_t filled;
+	size_t pending_size;  // of the other block, 0 once it's written
+	int quit;
+	int failed;
+
+	Uint64 offset;  // in the stream of the active block's start
+	CellsWord* shadow;  // grid as of the last record
+	size_t* columns;  // scratch, changed tile columns of a band
+	Uint64 modification;
+	Uint64 generation;
+	Uint64 keyframe_generation;
+
+	RecordingKeyframe* index;
+	size_t index_count, index_capacity;
+} Recorder;
+
+// Plays a recording back into a grid, forward at any speed or by seeking to a generation
+typedef struct PlayerStruct {
+	SDL_RWops* file;
+	size_t width, height;
+	Rule rule;
+	Uint64 data_start, data_end;  // records live in between, the index follows them
+
+	RecordingKeyframe* index;
+	size_t index_count;
+
+	Uint8* buffer;
+	size_t buffer_capacity;
+} Player;
+
+// Starts a recording with a keyframe of the grid. Returns NULL on failure
+Recorder* Recorder_create(const CellsGrid* cells_grid, const char* path);
+
+// Adds a record if the grid changed since the last one
+int Recorder_record(Recorder* recorder, const CellsGrid* cells_grid);
+
+// Writes out the remaining records and the index, then frees the recorder. Returns 0 if the whole stream was written
+int Recorder_close(Recorder* recorder);
+
+// Opens a recording, a stream cut short by a crash is read up to its last whole record. Returns NULL on failure
+Player* Player_open(const char* path);
+
+// Destructor
+void Player_delete(Player* player);
+
+// Applies the next record to the grid, which has to have the recording's size.
+// Returns 1 if it did, 0 at the end of the recording and -1 on failure
+int Player_step(Player* player, CellsGrid* cells_grid);
+
+// Loads the keyframe the generation follows and plays up to it. Generations recorded more than once, after
+// a rewind or restart, are found at their last recording. Returns 0 on success, -1 if it was never recorded
+int Player_seek(Player* player, CellsGrid* cells_grid, Uint64 generation);
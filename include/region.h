@@ -0,0 +1,21 @@
+#pragma once
+
+#include "cells.h"
+
+// Rectangle of cells lifted off a grid, packed the same way, 64 to a word with rows starting on a word. Copying
+// and pasting shift whole words into place, so it costs about as much as a memcpy of the packed rows
+typedef struct CellsRegionStruct {
+	size_t width, height;
+	size_t words_per_row;
+	CellsWord* cells;
+} CellsRegion;
+
+// Constructor copying the rectangle at (x, y), clipped to the grid. Returns NULL on failure or if it's empty
+CellsRegion* CellsRegion_copy(const CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height);
+
+// Destructor
+void CellsRegion_delete(CellsRegion* region);
+
+// Puts the region's top left corner at (x, y), whatever falls off the grid is dropped. Merging keeps the grid's
+// live cells under the region's dead ones, otherwise the rectangle is replaced
+void CellsRegion_paste(const CellsRegion* region, CellsGrid* cells_grid, size_t x, size_t y, int merge);
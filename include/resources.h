@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+
+// Files compiled into the executable by cmake/Embed.cmake, so starting up reads nothing from disk. Each is
+// followed by a zero not counted in its length
+
+extern const unsigned char RESOURCE_FONT[];
+extern const size_t RESOURCE_FONT_LENGTH;
+
+// Empty in builds that can't bake it
+extern const unsigned char RESOURCE_FONT_ATLAS[];
+extern const size_t RESOURCE_FONT_ATLAS_LENGTH;
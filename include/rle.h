@@ -0,0 +1,11 @@
+#pragma once
+
+#include "cells.h"
+
+// Reads a pattern in the RLE format ("x = 3, y = 3, rule = B3/S23" header, then runs of b/o/$ up to '!') and
+// sets its alive cells in the grid, either centered or with its top left corner at (x, y). Cells falling
+// outside of the grid are dropped, the rule from the header replaces the grid's one. Returns 0 on success
+int Rle_load(CellsGrid* cells_grid, const char* path, int centered, long long x, long long y);
+
+// Writes the whole grid as RLE, trailing dead cells of rows and trailing empty rows are left out
+int Rle_save(const CellsGrid* cells_grid, const char* path);
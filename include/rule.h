@@ -0,0 +1,20 @@
+#pragma once
+
+#include "SDL.h"
+
+// Outer totalistic rule, bit n of each mask is set if n alive neighbours cause a birth / let a cell survive
+typedef struct RuleStruct {
+	Uint16 birth, survival;
+} Rule;
+
+#define RULE_CONWAY ((Rule){1 << 3, (1 << 2) | (1 << 3)})
+
+// Accepts "B3/S23" and "23/3" (survival/birth) notations, case insensitive. Returns 0 on success
+int Rule_parse(const char* text, Rule* rule);
+
+// Writes the rule in B/S notation, e.g. "B36/S23"
+void Rule_format(Rule rule, char* buffer, size_t size);
+
+static inline int Rule_is_conway(Rule rule) {
+	return rule.birth == RULE_CONWAY.birth && rule.survival == RULE_CONWAY.survival;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "SDL.h"
+
+// Run-length coding tuned for cell data. Data is a stream of tokens, each a varint count whose low bit tells
+// the kind: for words it's set for a run of empty words and clear for that many words copied as is, for bytes
+// it's set for a run of the one byte that follows and clear for that many bytes copied as is
+
+// Worst case size of coded data, when words alternate between empty and not
+#define RUNS_WORDS_BOUND(count) ((count) * (sizeof(Uint64) + 10) + 10)
+
+size_t Runs_put_varint(Uint8* out, Uint64 value);
+const Uint8* Runs_get_varint(const Uint8* in, const Uint8* end, Uint64* value);
+
+// Return coded size, or 0 if it would exceed capacity
+size_t Runs_encode_words(const Uint64* words, size_t count, Uint8* out, size_t capacity);
+size_t Runs_encode_bytes(const Uint8* bytes, size_t count, Uint8* out, size_t capacity);
+
+// Decode exactly count words or bytes and return where the tokens for them end, NULL if the data is malformed.
+// Runs of empty words are skipped, so words have to be zeroed beforehand unless literals are XORed into them
+const Uint8* Runs_decode_words(const Uint8* in, const Uint8* end, Uint64* words, size_t count, int xor);
+const Uint8* Runs_decode_bytes(const Uint8* in, const Uint8* end, Uint8* bytes, size_t count);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "cells.h"
+
+// Payload of one stored deflate block, PNG image data is split into blocks of this size
+#define IMAGE_BLOCK_SIZE 65535
+
+// Streams an image to a PNG (with stored, uncompressed deflate blocks) or a top-down BMP file one row at a time,
+// so no more than a block of it is ever held in memory. Rows are either packed one bit per pixel indexing a two
+// color palette, or 24-bit RGB
+typedef struct ImageWriterStruct {
+	FILE* file;
+	char path[512];
+	int is_bmp;
+	size_t width, height;
+	int bits_per_pixel;  // 1 or 24
+	size_t row_size;  // of a packed row, without PNG filter byte or BMP padding
+	size_t rows_written;
+	int failed;
+
+	Uint8* row;  // BMP scratch, the row in BGR order padded to 4 bytes
+
+	Uint8* block;  // PNG, zlib header, stored block header, payload and Adler-32 laid out as one IDAT chunk
+	size_t block_filled;
+	Uint64 data_left;  // of the zlib payload, not yet put into a block
+	Uint32 adler_a, adler_b;
+	int block_first;
+} ImageWriter;
+
+// Starts an image, .bmp paths get BMP and anything else PNG. Palette is NULL for RGB rows, otherwise it holds
+// the colors of pixel values 0 and 1. Returns NULL on failure
+ImageWriter* ImageWriter_open(const char* path, size_t width, size_t height, const SDL_Color* palette);
+
+// Appends the next row of row_size bytes
+int ImageWriter_write_row(ImageWriter* writer, const Uint8* row);
+
+// Finishes the image and frees the writer, a file that wasn't written whole is removed. Returns 0 on success
+int ImageWriter_close(ImageWriter* writer);
+
+// Writes an image of the whole board with the colors CellsGrid_draw uses, cell_size pixels per cell. Strips of
+// rows are rasterised on every core and streamed in order, so memory use doesn't grow with the board.
+// The grid must not change until it returns. Returns 0 on success
+int Screenshot_save(const CellsGrid* cells_grid, const Gradient* gradient, const char* path);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "cells.h"
+#include "history.h"
+#include "recording.h"
+#include "region.h"
+
+// Generations per second it starts at
+#define SIMULATION_DEFAULT_RATE 60
+
+// Commands waiting for the simulation thread, far more than the UI sends in a frame
+#define SIMULATION_QUEUE_LENGTH 4096
+
+// Boards whose snapshot takes more bytes than this, about 64k by 64k cells without fading, get a single snapshot
+// guarded by a lock instead of three. They take twice their memory rather than four times, but the view falls
+// behind whenever the simulation finds the snapshot being read
+#define SIMULATION_SNAPSHOT_LIMIT ((size_t)512 << 20)
+
+enum SimulationCommands {
+	SIMULATION_PAINT,  // stroke from from_x, from_y to x, y with a brush of radius, value non-zero for alive
+	SIMULATION_RANDOMIZE,
+	SIMULATION_CLEAR,
+	SIMULATION_TOGGLE_PAUSE,
+	SIMULATION_SET_RATE,  // value in generations per second, 0 for as fast as it can
+	SIMULATION_REWIND,  // one entry of history (or generation of a recording) back, pauses
+	SIMULATION_SEEK,  // value generations forward through a recording, back if negative
+	SIMULATION_SET_HEAT,  // value non-zero to track how often tiles change
+	SIMULATION_COPY,  // rectangle with corners from_x, from_y and x, y into the clipboard
+	SIMULATION_CUT,  // same, then clears the rectangle
+	SIMULATION_PASTE  // clipboard with its top left corner at x, y, value non-zero merges it with the cells under it
+};
+
+// Totals since the simulation started
+typedef struct SimulationStatsStruct {
+	Uint64 generations;
+	Uint64 cells;  // in the tiles stepped, playing a recording back steps none
+	Uint64 step_time;  // in performance counter ticks
+} SimulationStats;
+
+typedef struct SimulationCommandStruct {
+	enum SimulationCommands type;
+	size_t x, y;
+	size_t from_x, from_y;
+	unsigned int radius;
+	Sint64 value;
+} SimulationCommand;
+
+// Steps a grid on its own thread at a fixed rate, edited only through a single producer, single consumer queue of commands.
+// Every generation and edit is published into one of three snapshots: the thread fills the back one, swaps
+// it with the latest and the reader swaps its front one with the latest when there's a newer one, so neither
+// side ever waits on the other. Snapshots are brought up to date by copying only the tiles changed since
+// they were last filled. Past SIMULATION_SNAPSHOT_LIMIT there's only one, which the reader locks from
+// Simulation_latest to Simulation_release. Either side only takes it if it's free, so neither waits: the thread
+// publishes on a later loop and the reader skips a frame
+typedef struct SimulationStruct {
+	CellsGrid* cells_grid;
+	Player* player;  // played instead of stepping if not NULL
+	History* history;
+	Recorder* recorder;
+
+	CellsGrid* snapshots[3];  // only the first one past SIMULATION_SNAPSHOT_LIMIT
+	SimulationStats stats[3];  // as of each snapshot
+	SDL_mutex* lock;  // of the only snapshot, NULL if there are three
+	SDL_atomic_t latest;  // index of the snapshot published last, flagged until the reader takes it
+	int back;  // the thread's
+	int front;  // the reader's
+	int held;  // by the reader, front isn't swapped out while set
+	int locked;  // by the reader, the only snapshot
+	SimulationStats front_stats;  // copied when the reader takes a snapshot
+
+	SimulationCommand commands[SIMULATION_QUEUE_LENGTH];
+	SDL_atomic_t head;  // next command to be sent, only moved by the UI
+	SDL_atomic_t tail;  // next command to be run, only moved by the thread
+	SDL_sem* commands_sent;  // posted with every command, the thread sleeps on it while paused
+
+	SDL_atomic_t quit;
+	SDL_Thread* thread;
+
+	// Set while the reader blocks on its event queue, publishing then pushes wake_event to it
+	SDL_atomic_t waiting;
+	Uint32 wake_event;  // (Uint32)-1 if none could be registered
+
+	// Only touched by the thread
+	CellsRegion* clipboard;  // NULL if nothing was copied
+	SimulationStats totals;
+	int unpublished;  // changes the only snapshot was locked for
+	int pause;
+	Uint64 rate;
+	Uint64 accumulator;  // performance counter ticks since the last generation, times the rate
+	Uint64 last_time;
+} Simulation;
+
+// Starts the thread paused, it uses the grid, player, history and recorder until Simulation_delete returns.
+// Returns NULL on failure
+Simulation* Simulation_create(CellsGrid* cells_grid, Player* player, History* history, Recorder* recorder);
+
+// Stops the thread and frees the snapshots, what it used stays with the caller
+void Simulation_delete(Simulation* simulation);
+
+// Queues a command, never waits. Returns 0 on success, -1 if the queue is full
+int Simulation_send(Simulation* simulation, const SimulationCommand* command);
+
+// Latest complete generation, unchanged until the next call. Only ever called from one thread. Returns NULL while
+// the thread fills the only snapshot, there's nothing to read until it's done
+const CellsGrid* Simulation_latest(Simulation* simulation);
+
+// Done reading the latest generation for now, lets the thread publish into the only snapshot if there's one.
+// It stays locked while held
+void Simulation_release(Simulation* simulation);
+
+// While held, Simulation_latest keeps returning the same snapshot so another thread can read it meanwhile.
+// The simulation goes on publishing into the other two
+void Simulation_hold(Simulation* simulation, int hold);
+
+// Blocks until an event comes in, a generation newer than the latest one taken is published or timeout
+// milliseconds pass. The event is left in the queue
+void Simulation_wait(Simulation* simulation, Uint32 timeout);
+
+// Stats as of the snapshot Simulation_latest returned last
+static inline const SimulationStats* Simulation_stats(const Simulation* simulation) {
+	return &simulation->front_stats;
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "SDL2_framerate.h"
+#include "SDL.h"
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 	#define BLACK_HEX 0x000000ff
@@ -24,7 +24,11 @@ enum Directions {
 	NA = 0
 };
 
-int init_SDL(SDL_Window** window, SDL_Renderer** renderer, FPSmanager* fps_manager, int window_width, int window_height);
+// Also gives the refresh rate of the window's display, 0 if it's unknown, and whether presenting waits for vsync
+int init_SDL(SDL_Window** window, SDL_Renderer** renderer, int* refresh_rate, int* vsync, int window_width, int window_height);
 void close_SDL(SDL_Window* window, SDL_Renderer* renderer);
 
 void clear_screen(SDL_Renderer* renderer, Uint32 color);
+
+// Case-insensitive check of the file name ending, e.g. has_extension(path, ".mc")
+int has_extension(const char* path, const char* extension);
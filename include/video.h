@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cells.h"
+
+// Frames waiting between two stages of the video pipeline
+#define VIDEO_QUEUE_LENGTH 3
+
+// Bounded queue between one producer and one consumer thread. Slots are filled in place, the producer waits
+// while all of them are taken and the consumer while none are ready
+typedef struct VideoQueueStruct {
+	SDL_mutex* lock;
+	SDL_cond* changed;
+	size_t first, count;
+	int closed;  // no more slots will be pushed
+} VideoQueue;
+
+// Copy of what a frame is rendered from, so the simulation can go on meanwhile
+typedef struct VideoSnapshotStruct {
+	CellsWord* cells;
+	Uint8* age;  // NULL if ages aren't tracked
+	Uint64* age_generation;
+	Uint64 generation;
+} VideoSnapshot;
+
+// Turns generations into a Y4M (4:4:4) or a PPM stream. Snapshots are rasterised on one thread and the frames
+// written on another, while the caller steps the grid
+typedef struct VideoEncoderStruct {
+	FILE* file;
+	int is_y4m;
+	size_t width, height;  // of the board
+	unsigned int scale;  // frame pixels per cell side
+	Uint8 palette[2][CELL_AGE_MAX + 1][3];  // [alive][age], RGB or YUV
+	int has_age;
+
+	VideoSnapshot snapshots[VIDEO_QUEUE_LENGTH];
+	Uint8* frames[VIDEO_QUEUE_LENGTH];
+	VideoQueue snapshot_queue, frame_queue;
+	SDL_Thread* raster_thread;
+	SDL_Thread* write_thread;
+	int failed;
+} VideoEncoder;
+
+// Starts the pipeline for a grid of this size and age tracking, .y4m paths get Y4M and anything else PPM.
+// Returns NULL on failure
+VideoEncoder* VideoEncoder_create(const CellsGrid* cells_grid, const Gradient* gradient, unsigned int scale, unsigned int fps, const char* path);
+
+// Queues the grid's current state, waits while the queue is full. Returns 0 on success
+int VideoEncoder_add_frame(VideoEncoder* encoder, const CellsGrid* cells_grid);
+
+// Waits for queued frames to be written and frees the encoder. Returns 0 if the whole video was written
+int VideoEncoder_finish(VideoEncoder* encoder);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "cells.h"
+#include "density.h"
+
+// Closest and farthest zoom, in pixels per cell and cells per pixel
+#define VIEW_MAX_PIXELS_PER_CELL 64
+#define VIEW_MAX_CELLS_PER_PIXEL 65536
+
+// Mesh lines are drawn from this zoom in, closer ones would bury the cells
+#define VIEW_MIN_MESH_PIXELS_PER_CELL 4
+
+// Side of a mesh tile in pixels, rounded up to whole cells
+#define VIEW_MESH_TILE_PIXELS 256
+
+// Texels of the heat overlay are at least this many pixels wide, tiles are grouped into them when zoomed out.
+// A texel's heat is the hottest of up to this many tiles a side spread over its group
+#define VIEW_MIN_HEAT_PIXELS 4
+#define VIEW_HEAT_SAMPLES 4
+
+// Camera over a grid and the texture its visible part is drawn through. Every texel is a cell, or when zoomed
+// out a square block of cells shaded by how many of them live, and is scaled up to the viewport with nearest
+// filtering in a single copy. Zoomed in, only tiles changed since the last frame (or still fading) are redrawn, in runs of
+// tiles uploaded with SDL_UpdateTexture, so a paused board uploads nothing. Work only depends on the viewport size
+typedef struct CellsViewStruct {
+	SDL_Texture* texture;
+	int texture_width, texture_height;  // texels, enough to cover the viewport at any zoom
+	Uint32* pixels;  // copy of the texture the texels are redrawn into
+
+	unsigned int pixels_per_cell;  // 1 when zoomed out
+	unsigned int cells_per_pixel;  // power of two, 1 when zoomed in
+	size_t x, y;  // viewport's top left corner, in pixels of the board at the current zoom
+
+	// What the texture holds: the cell at texel (0, 0), tile aligned when zoomed in, and the zoom it was drawn at
+	size_t origin_x, origin_y;
+	unsigned int drawn_cells_per_pixel;  // 0 if it holds nothing yet
+
+	const Gradient* gradient;  // the palette was built from
+	Uint32 palette[2][CELL_AGE_MAX + 1];  // [alive][age], ARGB8888
+	Uint32 shades[256];  // from dead to alive, fully faded, for densities on a log scale
+
+	DensityPyramid* density;  // live counts of blocks, made the first time it's zoomed out far enough
+
+	Uint64 modification;  // grid's as of the last frame
+	Uint64 generation;
+	Uint64* settled;  // per texture tile, generation its colors stop fading at
+	size_t uploaded_cells;  // by the last frame
+	Uint64 update_time;  // performance counter ticks the last frame spent recoloring and uploading
+
+	// Tiles of mesh lines repeated over the board, per pixels per cell. Only zooms reachable from the grid's cell
+	// size have one
+	SDL_Texture* mesh_tiles[VIEW_MAX_PIXELS_PER_CELL + 1];
+
+	// Translucent overlay of how often tiles changed, a texel per square group of tiles starting at the heat
+	// origin. Only redrawn when the grid or the group under the viewport changed
+	SDL_Texture* heat_texture;
+	int heat_texture_width, heat_texture_height;
+	Uint32* heat_pixels;
+	Uint32 heat_colors[256];  // from cold to CELLS_HEAT_MAX, ARGB8888
+	int heat_drawn;  // 0 if the texture doesn't hold the heat below
+	size_t heat_origin_x, heat_origin_y;  // in texels
+	size_t heat_group;
+	Uint64 heat_modification;
+} CellsView;
+
+// Constructor, the camera starts at the top left corner with the grid's cell size. Returns NULL on failure
+CellsView* CellsView_create(SDL_Renderer* renderer, const CellsGrid* cells_grid, const SDL_Rect* viewport);
+
+// Destructor
+void CellsView_delete(CellsView* view);
+
+// Zooms in (positive steps) or out by factors of two, keeping the cell under the viewport point (x, y) in place.
+// Zooming out stops once the whole grid fits
+void CellsView_zoom(CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int steps, int x, int y);
+
+// Moves the board by this many pixels, the camera stays within the grid
+void CellsView_pan(CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int dx, int dy);
+
+// Finds the cell under the viewport point (x, y). Returns 0 if there's one
+int CellsView_cell_at(const CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int x, int y, size_t* cell_x, size_t* cell_y);
+
+// Draws the visible cells into the viewport, the mesh over them if asked to and zoomed in far enough, and over
+// that the heat of tiles if asked to and the grid tracks it
+void CellsView_draw(CellsView* view, const CellsGrid* cells_grid, SDL_Renderer* renderer, const SDL_Rect* viewport, const Gradient* gradient, int draw_mesh, int draw_heat);
+
+// Outlines the rectangle of width by height cells from the cell (x, y), drawn after the cells
+void CellsView_draw_selection(const CellsView* view, SDL_Renderer* renderer, const SDL_Rect* viewport, size_t x, size_t y, size_t width, size_t height);
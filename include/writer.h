@@ -0,0 +1,37 @@
+#pragma once
+
+#include "cells.h"
+#include "gradient.h"
+
+enum BoardWrites {
+	BOARD_WRITE_SAVE,  // grid file
+	BOARD_WRITE_EXPORT,  // RLE or macrocell pattern, depending on the extension
+	BOARD_WRITE_SCREENSHOT,  // PNG or BMP image
+	BOARD_WRITE_CHECKPOINT
+};
+
+// Writes a board to a file on a background thread, one write at a time, so the window stays responsive however
+// big the board is. The board is read until reading is cleared, checkpoints stop reading it once it's compressed
+typedef struct BoardWriterStruct {
+	SDL_Thread* thread;
+	SDL_atomic_t reading;
+	SDL_atomic_t done;
+	enum BoardWrites type;
+	const CellsGrid* cells_grid;
+	const Gradient* gradient;  // of screenshots
+	char path[512];
+	int result;
+} BoardWriter;
+
+// Starts writing the board, which must not change while BoardWriter_reading. Fails if the previous write is
+// still running. Returns 0 on success
+int BoardWriter_start(BoardWriter* writer, enum BoardWrites type, const CellsGrid* cells_grid, const Gradient* gradient, const char* path);
+
+// Non-zero while the running write still reads the board
+int BoardWriter_reading(BoardWriter* writer);
+
+// Non-zero while a write is running
+int BoardWriter_busy(BoardWriter* writer);
+
+// Waits for the running write, if any, and returns its result
+int BoardWriter_finish(BoardWriter* writer);
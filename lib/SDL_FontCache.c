@@ -1292,6 +1292,52 @@ Uint8 FC_LoadFontFromTTF(FC_Font* font, SDL_Renderer* renderer, TTF_Font* ttf, S
 }
 
 
+// Glyphs packed ahead of time are uploaded as they are, nothing is rasterized and codepoints missing from the
+// cache can't be drawn.  Their positions are set with FC_SetGlyphData() afterwards.
+#ifdef FC_USE_SDL_GPU
+Uint8 FC_LoadFontFromGlyphCache(FC_Font* font, SDL_Surface* cache_surface, Uint16 height, int ascent, int descent, SDL_Color color)
+#else
+Uint8 FC_LoadFontFromGlyphCache(FC_Font* font, SDL_Renderer* renderer, SDL_Surface* cache_surface, Uint16 height, int ascent, int descent, SDL_Color color)
+#endif
+{
+    if(font == NULL || cache_surface == NULL)
+        return 0;
+    #ifndef FC_USE_SDL_GPU
+    if(renderer == NULL)
+        return 0;
+    #endif
+
+    FC_ClearFont(font);
+
+    #ifdef FC_USE_SDL_GPU
+    fc_has_render_target_support = GPU_IsFeatureEnabled(GPU_FEATURE_RENDER_TARGETS);
+    #else
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(renderer, &info);
+    fc_has_render_target_support = (info.flags & SDL_RENDERER_TARGETTEXTURE);
+
+    font->renderer = renderer;
+    #endif
+
+    font->height = height;
+    font->ascent = ascent;
+    font->descent = descent;
+    if(font->height < font->ascent - font->descent)
+        font->height = font->ascent - font->descent;
+    font->baseline = font->height - font->descent;
+
+    font->default_color = color;
+
+    if(!FC_UploadGlyphCache(font, 0, cache_surface))
+        return 0;
+    #ifndef FC_USE_SDL_GPU
+    SDL_SetTextureBlendMode(font->glyph_cache[0], SDL_BLENDMODE_BLEND);
+    #endif
+
+    return 1;
+}
+
+
 #ifdef FC_USE_SDL_GPU
 Uint8 FC_LoadFont(FC_Font* font, const char* filename_ttf, Uint32 pointSize, SDL_Color color, int style)
 #else
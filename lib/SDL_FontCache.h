@@ -135,12 +135,17 @@ Uint8 FC_LoadFont(FC_Font* font, const char* filename_ttf, Uint32 pointSize, SDL
 Uint8 FC_LoadFontFromTTF(FC_Font* font, TTF_Font* ttf, SDL_Color color);
 
 Uint8 FC_LoadFont_RW(FC_Font* font, SDL_RWops* file_rwops_ttf, Uint8 own_rwops, Uint32 pointSize, SDL_Color color, int style);
+
+Uint8 FC_LoadFontFromGlyphCache(FC_Font* font, SDL_Surface* cache_surface, Uint16 height, int ascent, int descent, SDL_Color color);
 #else
 Uint8 FC_LoadFont(FC_Font* font, SDL_Renderer* renderer, const char* filename_ttf, Uint32 pointSize, SDL_Color color, int style);
 
 Uint8 FC_LoadFontFromTTF(FC_Font* font, SDL_Renderer* renderer, TTF_Font* ttf, SDL_Color color);
 
 Uint8 FC_LoadFont_RW(FC_Font* font, SDL_Renderer* renderer, SDL_RWops* file_rwops_ttf, Uint8 own_rwops, Uint32 pointSize, SDL_Color color, int style);
+
+// Uses glyphs baked ahead of time instead of a TTF, set their positions with FC_SetGlyphData()
+Uint8 FC_LoadFontFromGlyphCache(FC_Font* font, SDL_Renderer* renderer, SDL_Surface* cache_surface, Uint16 height, int ascent, int descent, SDL_Color color);
 #endif
 
 #ifndef FC_USE_SDL_GPU
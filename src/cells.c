@@ -1,8 +1,35 @@
 #include "../include/cells.h"
+#include "../include/gridfile.h"
 #include "../include/utils.h"
 
-CellsGrid* CellsGrid_create(size_t width, size_t height, unsigned int cell_size) {
-	CellsGrid* cells_grid = malloc(sizeof(CellsGrid));
+// Age a cell gets when it's set by hand - alive ones flash white, dead ones are shown fully faded
+static inline Uint8 edit_age(int is_alive) {
+	return is_alive ? 0 : CELL_AGE_MAX;
+}
+
+static inline Uint8 add_age(Uint8 age, Uint64 generations) {
+	return generations < (Uint64)(CELL_AGE_MAX - age) ? age + generations : CELL_AGE_MAX;
+}
+
+// Seed of grids nobody seeded, CellsGrid_create takes its own
+static const Uint64 CELLS_DEFAULT_SEED = 1;
+
+// splitmix64, fast and good enough for whole random words
+static inline Uint64 next_random(Uint64* state) {
+	Uint64 z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// Mask of the bits of the last word in a row that hold cells
+static inline CellsWord last_word_mask(size_t width) {
+	unsigned int used = width % CELLS_WORD_BITS;
+	return used == 0 ? ~(CellsWord)0 : ((CellsWord)1 << used) - 1;
+}
+
+CellsGrid* CellsGrid_create_mapped(size_t width, size_t height, unsigned int cell_size, CellsWord* cells, void* mapping, size_t mapping_size) {
+	CellsGrid* cells_grid = calloc(1, sizeof(CellsGrid));
 	if (cells_grid == NULL) {
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells grid\n");
 		return NULL;
@@ -10,73 +37,741 @@ CellsGrid* CellsGrid_create(size_t width, size_t height, unsigned int cell_size)
 
 	cells_grid->width = width;
 	cells_grid->height = height;
+	cells_grid->words_per_row = (width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS;
+	cells_grid->tiles_x = cells_grid->words_per_row;
+	cells_grid->tiles_y = (height + CELLS_TILE_ROWS - 1) / CELLS_TILE_ROWS;
 	cells_grid->cell_size = cell_size;
+	cells_grid->rule = RULE_CONWAY;
+	cells_grid->random_state = CELLS_DEFAULT_SEED;
+	cells_grid->cells = cells;
+	cells_grid->mapping = mapping;
+	cells_grid->mapping_size = mapping_size;
+
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+
+	// Rows above, at and below the one being stepped, plus a run bound per tile
+	cells_grid->row_buffers = malloc(sizeof(CellsWord) * cells_grid->words_per_row * 3);
+	cells_grid->spans = malloc(sizeof(size_t) * (cells_grid->tiles_x + 1));
+	cells_grid->halo = calloc(tiles, sizeof(CellsWord));
+	cells_grid->tile_active = malloc(tiles);
+	cells_grid->tile_changed = calloc(tiles, 1);
+	cells_grid->tile_modification = calloc(tiles, sizeof(Uint64));
+	cells_grid->tile_row_modification = calloc(cells_grid->tiles_y, sizeof(Uint64));
+	if (cells_grid->row_buffers == NULL || cells_grid->spans == NULL || cells_grid->halo == NULL || cells_grid->tile_active == NULL ||
+		cells_grid->tile_changed == NULL || cells_grid->tile_modification == NULL || cells_grid->tile_row_modification == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells step buffers\n");
+
+		// Cells stay with the caller on failure
+		cells_grid->cells = NULL;
+		cells_grid->mapping = NULL;
+		CellsGrid_delete(cells_grid);
+		return NULL;
+	}
+	memset(cells_grid->tile_active, 1, tiles);
+
+	return cells_grid;
+}
+
+CellsGrid* CellsGrid_create(size_t width, size_t height, unsigned int cell_size, Uint64 seed) {
+	size_t words = (width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS * height;
+
+	// Create packed cells, zeroed pages are mapped lazily so even huge boards are cheap until touched
+	CellsWord* cells = calloc(words, sizeof(CellsWord));
+	if (cells == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for %zux%zu cells\n", width, height);
+		return NULL;
+	}
+
+	CellsGrid* cells_grid = CellsGrid_create_mapped(width, height, cell_size, cells, NULL, 0);
+	if (cells_grid == NULL) {
+		free(cells);
+		return NULL;
+	}
+
+	CellsGrid_seed(cells_grid, seed);
+	CellsGrid_randomize(cells_grid);
+
+	return cells_grid;
+}
 
-	// Create cells in columns
-	Cell** cell = malloc(sizeof(Cell) * width);
-	if (cell == NULL) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells in columns\n");
+CellsGrid* CellsGrid_create_snapshot(const CellsGrid* cells_grid) {
+	CellsGrid* snapshot = calloc(1, sizeof(CellsGrid));
+	if (snapshot == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells snapshot\n");
 		return NULL;
 	}
 
-	// Create cells in rows
-	for (size_t i = 0; i < width; ++i) {
-		cell[i] = malloc(sizeof(Cell) * height);
-		if (cell[i] == NULL) {
-			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells in rows\n");
-			return NULL;
+	snapshot->width = cells_grid->width;
+	snapshot->height = cells_grid->height;
+	snapshot->words_per_row = cells_grid->words_per_row;
+	snapshot->tiles_x = cells_grid->tiles_x;
+	snapshot->tiles_y = cells_grid->tiles_y;
+	snapshot->cell_size = cells_grid->cell_size;
+
+	// A mapped grid's file is mapped again, so the snapshot reads only what it's asked for, like the grid
+	size_t words = cells_grid->words_per_row * cells_grid->height, tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	snapshot->mapping = GridFile_map_again(cells_grid, &snapshot->mapping_size);
+	if (snapshot->mapping != NULL) {
+		snapshot->cells = (CellsWord*)((Uint8*)snapshot->mapping + ((Uint8*)cells_grid->cells - (Uint8*)cells_grid->mapping));
+	}
+	else {
+		snapshot->cells = calloc(words, sizeof(CellsWord));
+	}
+	snapshot->tile_modification = calloc(tiles, sizeof(Uint64));
+	snapshot->tile_row_modification = calloc(cells_grid->tiles_y, sizeof(Uint64));
+	snapshot->tile_heat = calloc(tiles, sizeof(Uint16));  // holds the grid's heat whenever it's tracked
+	if (cells_grid->age != NULL) {
+		snapshot->age = malloc(cells_grid->width * cells_grid->height);
+		snapshot->age_generation = malloc(sizeof(Uint64) * tiles);
+	}
+	if (snapshot->cells == NULL || snapshot->tile_modification == NULL || snapshot->tile_row_modification == NULL || snapshot->tile_heat == NULL || (cells_grid->age != NULL && (snapshot->age == NULL || snapshot->age_generation == NULL))) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells snapshot\n");
+		CellsGrid_delete(snapshot);
+		return NULL;
+	}
+
+	// The file holds the grid as it was mapped, before any tile was stamped, so only stamped tiles are copied.
+	// Allocated cells are copied whole as tiles that were never stamped wouldn't be otherwise, skipping empty
+	// words so the snapshot's untouched pages stay unallocated
+	if (snapshot->mapping == NULL) {
+		for (size_t i = 0; i < words; ++i) {
+			if (cells_grid->cells[i] != 0) {
+				snapshot->cells[i] = cells_grid->cells[i];
+			}
 		}
+		memcpy(snapshot->tile_modification, cells_grid->tile_modification, sizeof(Uint64) * tiles);
+		memcpy(snapshot->tile_row_modification, cells_grid->tile_row_modification, sizeof(Uint64) * cells_grid->tiles_y);
+		snapshot->modification = cells_grid->modification;
+	}
+	if (cells_grid->age != NULL) {
+		memcpy(snapshot->age, cells_grid->age, cells_grid->width * cells_grid->height);
+		memcpy(snapshot->age_generation, cells_grid->age_generation, sizeof(Uint64) * tiles);
 	}
+	CellsGrid_update_snapshot(snapshot, cells_grid);
+
+	return snapshot;
+}
+
+void CellsGrid_update_snapshot(CellsGrid* snapshot, const CellsGrid* cells_grid) {
+	// Runs of stamped tiles in a tile row are copied a row at a time. Ages of tiles stepped without changing
+	// aren't, their stored ages and generation stay consistent with each other
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y && cells_grid->modification != snapshot->modification; ++tile_y) {
+		if (cells_grid->tile_row_modification[tile_y] <= snapshot->modification) {
+			continue;
+		}
+		snapshot->tile_row_modification[tile_y] = cells_grid->tile_row_modification[tile_y];
+
+		const Uint64* stamps = cells_grid->tile_modification + tile_y * cells_grid->tiles_x;
+		size_t y0 = tile_y * CELLS_TILE_ROWS, y1 = SDL_min(y0 + CELLS_TILE_ROWS, cells_grid->height);
 
-	// Initialize cells
-	for (size_t x = 0; x < width; ++x) {
-		for (size_t y = 0; y < height; ++y) {
-			cell[x][y].pos_x = x * cell_size;
-			cell[x][y].pos_y = y * cell_size;
-			cell[x][y].is_alive = rand() % 2;
-			cell[x][y].alive_neighbours = 0;
-		
-			Uint8 color = cell[x][y].is_alive ? 255 : 0;
-			cell[x][y].r = color;
-			cell[x][y].g = color;
-			cell[x][y].b = color;
+		for (size_t begin = 0; begin < cells_grid->tiles_x; ++begin) {
+			if (stamps[begin] <= snapshot->modification) {
+				continue;
+			}
+			size_t end = begin + 1;
+			while (end < cells_grid->tiles_x && stamps[end] > snapshot->modification) {
+				++end;
+			}
+
+			size_t x0 = begin * CELLS_WORD_BITS, x1 = SDL_min(end * CELLS_WORD_BITS, cells_grid->width);
+			for (size_t y = y0; y < y1; ++y) {
+				memcpy(CellsGrid_row(snapshot, y) + begin, CellsGrid_row(cells_grid, y) + begin, sizeof(CellsWord) * (end - begin));
+				if (cells_grid->age != NULL) {
+					memcpy(snapshot->age + y * cells_grid->width + x0, cells_grid->age + y * cells_grid->width + x0, x1 - x0);
+				}
+			}
+			size_t tile = tile_y * cells_grid->tiles_x + begin;
+			memcpy(snapshot->tile_modification + tile, stamps + begin, sizeof(Uint64) * (end - begin));
+			if (cells_grid->age != NULL) {
+				memcpy(snapshot->age_generation + tile, cells_grid->age_generation + tile, sizeof(Uint64) * (end - begin));
+			}
+			begin = end;
 		}
 	}
 
-	cells_grid->cell = cell;
+	// Heat of every tile cools each step, so it's copied whole
+	if (cells_grid->tile_heat != NULL) {
+		memcpy(snapshot->tile_heat, cells_grid->tile_heat, sizeof(Uint16) * cells_grid->tiles_x * cells_grid->tiles_y);
+	}
 
-	return cells_grid;
+	snapshot->modification = cells_grid->modification;
+	snapshot->generation = cells_grid->generation;
+	snapshot->random_state = cells_grid->random_state;
+	snapshot->rule = cells_grid->rule;
 }
 
 void CellsGrid_delete(CellsGrid* cells_grid) {
-	for (size_t i = 0; i < cells_grid->width; ++i) {
-		free(cells_grid->cell[i]);
+	if (cells_grid->mapping != NULL) {
+		GridFile_unmap(cells_grid->mapping, cells_grid->mapping_size);
 	}
-	free(cells_grid->cell);
+	else {
+		free(cells_grid->cells);
+	}
+
+	free(cells_grid->row_buffers);
+	free(cells_grid->spans);
+	free(cells_grid->halo);
+	free(cells_grid->tile_active);
+	free(cells_grid->tile_changed);
+	free(cells_grid->tile_modification);
+	free(cells_grid->tile_row_modification);
+	free(cells_grid->age);
+	free(cells_grid->age_generation);
+	free(cells_grid->tile_heat);
+	free(cells_grid->mapping_path);
 
 	free(cells_grid);
 }
 
-void CellsGrid_draw(CellsGrid* cells_grid, SDL_Renderer* renderer, SDL_Rect* viewport, SDL_Texture* mesh_texture, int draw_mesh) {
-	for (size_t x = 0; x < cells_grid->width; ++x) {
-		for (size_t y = 0; y < cells_grid->height; ++y) {
-			if (SDL_RenderSetViewport(renderer, viewport) != 0) {
-				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to set viewport for cells grid: %s\n", SDL_GetError());
+// Brings stored ages of a tile up to the current generation
+static void refresh_tile_age(CellsGrid* cells_grid, size_t tile) {
+	Uint64 behind = cells_grid->generation - cells_grid->age_generation[tile];
+	if (behind == 0) {
+		return;
+	}
+
+	size_t x0 = tile % cells_grid->tiles_x * CELLS_WORD_BITS, y0 = tile / cells_grid->tiles_x * CELLS_TILE_ROWS;
+	size_t x1 = SDL_min(x0 + CELLS_WORD_BITS, cells_grid->width), y1 = SDL_min(y0 + CELLS_TILE_ROWS, cells_grid->height);
+	for (size_t y = y0; y < y1; ++y) {
+		Uint8* age = cells_grid->age + y * cells_grid->width;
+		for (size_t x = x0; x < x1; ++x) {
+			age[x] = add_age(age[x], behind);
+		}
+	}
+
+	cells_grid->age_generation[tile] = cells_grid->generation;
+}
+
+// Ages of every cell as if they were all just set by hand
+static void reset_ages(CellsGrid* cells_grid) {
+	for (size_t y = 0; y < cells_grid->height; ++y) {
+		for (size_t x = 0; x < cells_grid->width; ++x) {
+			cells_grid->age[y * cells_grid->width + x] = edit_age(CellsGrid_get_cell(cells_grid, x, y));
+		}
+	}
+	for (size_t i = 0; i < cells_grid->tiles_x * cells_grid->tiles_y; ++i) {
+		cells_grid->age_generation[i] = cells_grid->generation;
+	}
+}
+
+int CellsGrid_set_age_tracking(CellsGrid* cells_grid, int enabled) {
+	if (!enabled) {
+		free(cells_grid->age);
+		free(cells_grid->age_generation);
+		cells_grid->age = NULL;
+		cells_grid->age_generation = NULL;
+		return 0;
+	}
+	if (cells_grid->age != NULL) {
+		return 0;
+	}
+
+	cells_grid->age = malloc(cells_grid->width * cells_grid->height);
+	cells_grid->age_generation = malloc(sizeof(Uint64) * cells_grid->tiles_x * cells_grid->tiles_y);
+	if (cells_grid->age == NULL || cells_grid->age_generation == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells age plane\n");
+		CellsGrid_set_age_tracking(cells_grid, 0);
+		return -1;
+	}
+
+	// Without history every cell is treated as if it was just set by hand
+	reset_ages(cells_grid);
+
+	return 0;
+}
+
+int CellsGrid_set_heat_tracking(CellsGrid* cells_grid, int enabled) {
+	if (!enabled) {
+		free(cells_grid->tile_heat);
+		cells_grid->tile_heat = NULL;
+		return 0;
+	}
+	if (cells_grid->tile_heat != NULL) {
+		return 0;
+	}
+
+	cells_grid->tile_heat = calloc(cells_grid->tiles_x * cells_grid->tiles_y, sizeof(Uint16));
+	if (cells_grid->tile_heat == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for tile heat\n");
+		return -1;
+	}
+
+	// No tile changed, but whoever drew the old heat has to look again
+	++cells_grid->modification;
+
+	return 0;
+}
+
+// Marks tile as changed, so it and its neighbours are stepped next time
+static inline void activate_around(CellsGrid* cells_grid, size_t tile_x, size_t tile_y) {
+	for (int dy = -1; dy <= 1; ++dy) {
+		size_t y = (tile_y + cells_grid->tiles_y + dy) % cells_grid->tiles_y;
+		for (int dx = -1; dx <= 1; ++dx) {
+			size_t x = (tile_x + cells_grid->tiles_x + dx) % cells_grid->tiles_x;
+			cells_grid->tile_active[y * cells_grid->tiles_x + x] = 1;
+		}
+	}
+}
+
+void CellsGrid_set_cell(CellsGrid* cells_grid, size_t x, size_t y, int is_alive) {
+	CellsWord* word = &CellsGrid_row(cells_grid, y)[x / CELLS_WORD_BITS];
+	CellsWord bit = (CellsWord)1 << (x % CELLS_WORD_BITS);
+	*word = is_alive ? *word | bit : *word & ~bit;
+
+	size_t tile = CellsGrid_tile_index(cells_grid, x, y);
+	activate_around(cells_grid, x / CELLS_WORD_BITS, y / CELLS_TILE_ROWS);
+	cells_grid->tile_changed[tile] = 1;
+	cells_grid->tile_modification[tile] = ++cells_grid->modification;
+	cells_grid->tile_row_modification[y / CELLS_TILE_ROWS] = cells_grid->modification;
+
+	if (cells_grid->age != NULL) {
+		refresh_tile_age(cells_grid, tile);
+		cells_grid->age[y * cells_grid->width + x] = edit_age(is_alive);
+	}
+}
+
+// Sets cells [x0, x1] of row y a word at a time, stamping their tiles with the current modification
+static void paint_span(CellsGrid* cells_grid, size_t y, size_t x0, size_t x1, int is_alive) {
+	CellsWord* row = CellsGrid_row(cells_grid, y);
+	size_t tile_y = y / CELLS_TILE_ROWS;
+	for (size_t i = x0 / CELLS_WORD_BITS; i <= x1 / CELLS_WORD_BITS; ++i) {
+		unsigned int begin = i == x0 / CELLS_WORD_BITS ? x0 % CELLS_WORD_BITS : 0;
+		unsigned int end = i == x1 / CELLS_WORD_BITS ? x1 % CELLS_WORD_BITS : CELLS_WORD_BITS - 1;
+		CellsWord mask = (~(CellsWord)0 >> (CELLS_WORD_BITS - 1 - end)) & (~(CellsWord)0 << begin);
+		row[i] = is_alive ? row[i] | mask : row[i] & ~mask;
+
+		size_t tile = tile_y * cells_grid->tiles_x + i;
+		activate_around(cells_grid, i, tile_y);
+		cells_grid->tile_changed[tile] = 1;
+		cells_grid->tile_modification[tile] = cells_grid->modification;
+		if (cells_grid->age != NULL) {
+			refresh_tile_age(cells_grid, tile);
+		}
+	}
+	cells_grid->tile_row_modification[tile_y] = cells_grid->modification;
+
+	if (cells_grid->age != NULL) {
+		memset(cells_grid->age + y * cells_grid->width + x0, edit_age(is_alive), x1 - x0 + 1);
+	}
+}
+
+// Disc of cells around (x, y), row by row. Its half width only shrinks going away from the middle row
+static void paint_disc(CellsGrid* cells_grid, size_t x, size_t y, unsigned int radius, int is_alive) {
+	long long r = radius, half_width = r;
+	for (long long dy = 0; dy <= r; ++dy) {
+		while (half_width * half_width + dy * dy > r * r) {
+			--half_width;
+		}
+		size_t x0 = (long long)x > half_width ? x - half_width : 0;
+		size_t x1 = SDL_min(x + half_width, cells_grid->width - 1);
+		if ((long long)y >= dy) {
+			paint_span(cells_grid, y - dy, x0, x1, is_alive);
+		}
+		if (dy > 0 && y + dy < cells_grid->height) {
+			paint_span(cells_grid, y + dy, x0, x1, is_alive);
+		}
+	}
+}
+
+void CellsGrid_paint(CellsGrid* cells_grid, size_t x0, size_t y0, size_t x1, size_t y1, unsigned int radius, int is_alive) {
+	++cells_grid->modification;
+
+	// Bresenham's line, so fast strokes leave no gaps between the points they were sampled at
+	long long x = x0, y = y0;
+	long long dx = x1 > x0 ? x1 - x0 : x0 - x1, dy = y1 > y0 ? y1 - y0 : y0 - y1;
+	int step_x = x1 > x0 ? 1 : -1, step_y = y1 > y0 ? 1 : -1;
+	long long error = dx - dy;
+	for (;;) {
+		paint_disc(cells_grid, x, y, radius, is_alive);
+		if (x == (long long)x1 && y == (long long)y1) {
+			break;
+		}
+
+		long long doubled = 2 * error;
+		if (doubled >= -dy) {
+			error -= dy;
+			x += step_x;
+		}
+		if (doubled <= dx) {
+			error += dx;
+			y += step_y;
+		}
+	}
+}
+
+void CellsGrid_fill(CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height, int is_alive) {
+	if (x >= cells_grid->width || y >= cells_grid->height || width == 0 || height == 0) {
+		return;
+	}
+
+	size_t x1 = SDL_min(x + width, cells_grid->width) - 1, y1 = SDL_min(y + height, cells_grid->height);
+	++cells_grid->modification;
+	for (size_t row = y; row < y1; ++row) {
+		paint_span(cells_grid, row, x, x1, is_alive);
+	}
+}
+
+void CellsGrid_touch(CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height) {
+	if (width == 0 || height == 0) {
+		return;
+	}
+
+	size_t x1 = SDL_min(x + width, cells_grid->width), y1 = SDL_min(y + height, cells_grid->height);
+	++cells_grid->modification;
+	for (size_t tile_y = y / CELLS_TILE_ROWS; tile_y <= (y1 - 1) / CELLS_TILE_ROWS; ++tile_y) {
+		for (size_t tile_x = x / CELLS_WORD_BITS; tile_x <= (x1 - 1) / CELLS_WORD_BITS; ++tile_x) {
+			size_t tile = tile_y * cells_grid->tiles_x + tile_x;
+			activate_around(cells_grid, tile_x, tile_y);
+			cells_grid->tile_changed[tile] = 1;
+			cells_grid->tile_modification[tile] = cells_grid->modification;
+
+			if (cells_grid->age != NULL) {
+				refresh_tile_age(cells_grid, tile);
+			}
+		}
+		cells_grid->tile_row_modification[tile_y] = cells_grid->modification;
+	}
+
+	if (cells_grid->age != NULL) {
+		for (size_t cy = y; cy < y1; ++cy) {
+			for (size_t cx = x; cx < x1; ++cx) {
+				cells_grid->age[cy * cells_grid->width + cx] = edit_age(CellsGrid_get_cell(cells_grid, cx, cy));
+			}
+		}
+	}
+}
+
+// Records a change of every tile
+static void stamp_all(CellsGrid* cells_grid) {
+	++cells_grid->modification;
+	for (size_t i = 0; i < cells_grid->tiles_x * cells_grid->tiles_y; ++i) {
+		cells_grid->tile_modification[i] = cells_grid->modification;
+	}
+	for (size_t i = 0; i < cells_grid->tiles_y; ++i) {
+		cells_grid->tile_row_modification[i] = cells_grid->modification;
+	}
+}
+
+void CellsGrid_randomize(CellsGrid* cells_grid) {
+	CellsWord mask = last_word_mask(cells_grid->width);
+
+	for (size_t y = 0; y < cells_grid->height; ++y) {
+		CellsWord* row = CellsGrid_row(cells_grid, y);
+		for (size_t i = 0; i < cells_grid->words_per_row; ++i) {
+			row[i] = next_random(&cells_grid->random_state);
+		}
+		row[cells_grid->words_per_row - 1] &= mask;
+	}
+
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	memset(cells_grid->tile_active, 1, tiles);
+	memset(cells_grid->tile_changed, 1, tiles);
+	stamp_all(cells_grid);
+
+	cells_grid->generation = 0;
+	if (cells_grid->age != NULL) {
+		reset_ages(cells_grid);
+	}
+}
+
+void CellsGrid_seed(CellsGrid* cells_grid, Uint64 seed) {
+	cells_grid->random_state = seed;
+}
+
+void CellsGrid_clear(CellsGrid* cells_grid) {
+	memset(cells_grid->cells, 0, sizeof(CellsWord) * cells_grid->words_per_row * cells_grid->height);
+
+	// An empty board stays empty unless the rule has births from nothing
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	memset(cells_grid->tile_active, cells_grid->rule.birth & 1, tiles);
+	memset(cells_grid->tile_changed, 1, tiles);
+	stamp_all(cells_grid);
+
+	cells_grid->generation = 0;
+	if (cells_grid->age != NULL) {
+		memset(cells_grid->age, edit_age(0), cells_grid->width * cells_grid->height);
+		memset(cells_grid->age_generation, 0, sizeof(Uint64) * tiles);
+	}
+}
+
+void CellsGrid_set_generation(CellsGrid* cells_grid, Uint64 generation) {
+	if (cells_grid->age != NULL) {
+		for (size_t i = 0; i < cells_grid->tiles_x * cells_grid->tiles_y; ++i) {
+			refresh_tile_age(cells_grid, i);
+			cells_grid->age_generation[i] = generation;
+		}
+
+		// Stored ages of every tile were rewritten
+		stamp_all(cells_grid);
+	}
+
+	cells_grid->generation = generation;
+}
+
+// Sum of three 1-bit numbers in every bit lane
+static inline void full_add(CellsWord a, CellsWord b, CellsWord c, CellsWord* sum, CellsWord* carry) {
+	CellsWord t = a ^ b;
+	*sum = t ^ c;
+	*carry = (a & b) | (t & c);
+}
+
+// Words holding the west (x - 1) and east (x + 1) neighbours of every cell in word i, wrapping around the row
+static inline CellsWord west_of(const CellsWord* row, size_t i, size_t words, unsigned int last_bit) {
+	CellsWord carry = i > 0 ? row[i - 1] >> (CELLS_WORD_BITS - 1) : (row[words - 1] >> last_bit) & 1;
+	return (row[i] << 1) | carry;
+}
+
+static inline CellsWord east_of(const CellsWord* row, size_t i, size_t words, unsigned int last_bit) {
+	CellsWord carry = i + 1 < words ? row[i + 1] << (CELLS_WORD_BITS - 1) : (row[0] & 1) << last_bit;
+	return (row[i] >> 1) | carry;
+}
+
+// Applies the rule to 64 cells at once by adding up the 8 neighbour words bit-sliced
+static inline CellsWord next_word(const CellsWord* above, const CellsWord* current, const CellsWord* below, size_t i, size_t words, unsigned int last_bit, int conway, Rule rule) {
+	CellsWord sum_above, carry_above, sum_below, carry_below;
+	full_add(west_of(above, i, words, last_bit), above[i], east_of(above, i, words, last_bit), &sum_above, &carry_above);
+	full_add(west_of(below, i, words, last_bit), below[i], east_of(below, i, words, last_bit), &sum_below, &carry_below);
+
+	CellsWord west = west_of(current, i, words, last_bit), east = east_of(current, i, words, last_bit);
+	CellsWord sum_middle = west ^ east, carry_middle = west & east;
+
+	// Count bits: ones (bit 0), twos (bit 1) and fours (bit 2 and up)
+	CellsWord ones, twos_a, twos_b, twos_c, fours_a, fours_b;
+	full_add(sum_above, sum_below, sum_middle, &ones, &twos_a);
+	full_add(carry_above, carry_below, carry_middle, &twos_b, &fours_a);
+	twos_c = twos_a ^ twos_b;
+	fours_b = twos_a & twos_b;
+
+	if (conway) {
+		// Exactly 2 or 3 neighbours: twos set, no fours; 3 needs ones, 2 needs the cell to be alive already
+		return twos_c & ~(fours_a | fours_b) & (ones | current[i]);
+	}
+
+	// Count is ones + 2 * twos_c + 4 * (fours_a + fours_b), match it against every count the rule mentions
+	CellsWord fours = fours_a ^ fours_b, eights = fours_a & fours_b;
+	CellsWord born = 0, survived = 0;
+	for (int n = 0; n <= 8; ++n) {
+		CellsWord equal = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos_c : ~twos_c) & ((n & 4) ? fours : ~fours) & ((n & 8) ? eights : ~eights);
+		born |= (rule.birth >> n & 1) ? equal : 0;
+		survived |= (rule.survival >> n & 1) ? equal : 0;
+	}
+
+	return (born & ~current[i]) | (survived & current[i]);
+}
+
+static inline void update_age(Uint8* age, CellsWord changed, unsigned int bits, Uint64 generations) {
+	Uint8 delta = generations < CELL_AGE_MAX ? generations : CELL_AGE_MAX;
+	for (unsigned int b = 0; b < bits; ++b) {
+		// Saturating increment, reset to 1 if the state has just flipped
+		Uint8 aged = age[b] + delta < CELL_AGE_MAX ? age[b] + delta : CELL_AGE_MAX;
+		Uint8 changed_mask = -(Uint8)((changed >> b) & 1);
+		age[b] = (aged & ~changed_mask) | (1 & changed_mask);
+	}
+}
+
+// Copies words a run of tiles [begin, end) needs from a row, which is the run plus one word on both sides
+static inline void copy_span(CellsWord* destination, const CellsWord* row, size_t begin, size_t end, size_t words) {
+	size_t from = begin > 0 ? begin - 1 : 0, to = end < words ? end + 1 : words;
+	memcpy(destination + from, row + from, sizeof(CellsWord) * (to - from));
+	if (begin == 0) {
+		destination[words - 1] = row[words - 1];
+	}
+	if (end == words) {
+		destination[0] = row[0];
+	}
+}
+
+// Fills spans with [begin, end) pairs of active tile runs in a tile row, returns their count
+static size_t find_spans(const CellsGrid* cells_grid, size_t tile_y) {
+	const Uint8* active = cells_grid->tile_active + tile_y * cells_grid->tiles_x;
+	size_t count = 0;
+
+	for (size_t i = 0; i < cells_grid->tiles_x; ++i) {
+		if (active[i] && (i == 0 || !active[i - 1])) {
+			cells_grid->spans[count++] = i;
+		}
+		if (active[i] && (i + 1 == cells_grid->tiles_x || !active[i + 1])) {
+			cells_grid->spans[count++] = i + 1;
+		}
+	}
+
+	return count;
+}
+
+// Steps active tiles of one tile row in place, keeping copies of the unmodified rows around the current one.
+// Always inlined so the width specialised variants below get the word count as a compile-time constant.
+static inline __attribute__((always_inline)) void step_tile_row(CellsGrid* cells_grid, size_t tile_y, size_t span_count, size_t words, unsigned int last_bit, CellsWord mask, int conway) {
+	CellsWord* above = cells_grid->row_buffers;
+	CellsWord* current = above + words;
+	const CellsWord* first = current + words;
+	const CellsWord* halo = cells_grid->halo + tile_y * words;
+	Uint8* changed = cells_grid->tile_changed + tile_y * cells_grid->tiles_x;
+	Uint64* age_generation = cells_grid->age != NULL ? cells_grid->age_generation + tile_y * cells_grid->tiles_x : NULL;
+	Rule rule = cells_grid->rule;
+
+	size_t y0 = tile_y * CELLS_TILE_ROWS, y1 = SDL_min(y0 + CELLS_TILE_ROWS, cells_grid->height);
+	for (size_t y = y0; y < y1; ++y) {
+		CellsWord* row = CellsGrid_row(cells_grid, y);
+		const CellsWord* row_above = y == y0 ? halo : above;
+		const CellsWord* below = y + 1 < cells_grid->height ? CellsGrid_row(cells_grid, y + 1) : first;
+		Uint8* age = cells_grid->age != NULL ? cells_grid->age + y * cells_grid->width : NULL;
+
+		for (size_t s = 0; s < span_count; s += 2) {
+			copy_span(current, row, cells_grid->spans[s], cells_grid->spans[s + 1], words);
+		}
+
+		for (size_t s = 0; s < span_count; s += 2) {
+			for (size_t i = cells_grid->spans[s]; i < cells_grid->spans[s + 1]; ++i) {
+				CellsWord word = next_word(row_above, current, below, i, words, last_bit, conway, rule);
+				if (i + 1 == words) {
+					word &= mask;
+				}
+				row[i] = word;
+				changed[i] |= word != current[i];
+
+				if (age != NULL) {
+					unsigned int bits = i + 1 < words ? CELLS_WORD_BITS : last_bit + 1;
+					update_age(age + i * CELLS_WORD_BITS, word ^ current[i], bits, cells_grid->generation + 1 - age_generation[i]);
+				}
 			}
+		}
+
+		CellsWord* swap = above;
+		above = current;
+		current = swap;
+	}
 
-			int return_code = boxRGBA(renderer,
-									   cells_grid->cell[x][y].pos_x, cells_grid->cell[x][y].pos_y,
-									   cells_grid->cell[x][y].pos_x + cells_grid->cell_size, cells_grid->cell[x][y].pos_y + cells_grid->cell_size,
-									   cells_grid->cell[x][y].r, cells_grid->cell[x][y].g, cells_grid->cell[x][y].b, 255);
-			if (return_code != 0) {
-				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render cell[%llu][%llu]\n", x, y);
+	if (age_generation != NULL) {
+		for (size_t s = 0; s < span_count; s += 2) {
+			for (size_t i = cells_grid->spans[s]; i < cells_grid->spans[s + 1]; ++i) {
+				age_generation[i] = cells_grid->generation + 1;
 			}
 		}
 	}
+}
+
+// Kernels for power-of-two widths running B3/S23, rows are whole words there so no masking or partial words
+// are needed
+#define DEFINE_STEP_KERNEL(words) \
+	static void step_tile_row_##words(CellsGrid* cells_grid, size_t tile_y, size_t span_count) { \
+		step_tile_row(cells_grid, tile_y, span_count, words, CELLS_WORD_BITS - 1, ~(CellsWord)0, 1); \
+	}
+
+DEFINE_STEP_KERNEL(1)
+DEFINE_STEP_KERNEL(2)
+DEFINE_STEP_KERNEL(4)
+DEFINE_STEP_KERNEL(8)
+DEFINE_STEP_KERNEL(16)
+DEFINE_STEP_KERNEL(32)
+DEFINE_STEP_KERNEL(64)
+DEFINE_STEP_KERNEL(128)
+DEFINE_STEP_KERNEL(256)
+
+#undef DEFINE_STEP_KERNEL
+
+static void step_tile_row_generic(CellsGrid* cells_grid, size_t tile_y, size_t span_count) {
+	size_t words = cells_grid->words_per_row;
+	unsigned int last_bit = (cells_grid->width - 1) % CELLS_WORD_BITS;
+	CellsWord mask = last_word_mask(cells_grid->width);
+
+	if (Rule_is_conway(cells_grid->rule)) {
+		step_tile_row(cells_grid, tile_y, span_count, words, last_bit, mask, 1);
+	}
+	else {
+		step_tile_row(cells_grid, tile_y, span_count, words, last_bit, mask, 0);
+	}
+}
+
+typedef void (*StepTileRowFunction)(CellsGrid* cells_grid, size_t tile_y, size_t span_count);
 
-	if (draw_mesh) {
-    if (SDL_RenderCopy(renderer, mesh_texture, NULL, NULL) != 0) {
-      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render mesh\n");
-    }
+static StepTileRowFunction pick_kernel(const CellsGrid* cells_grid) {
+	if (cells_grid->width % CELLS_WORD_BITS != 0 || !Rule_is_conway(cells_grid->rule)) {
+		return step_tile_row_generic;
 	}
+
+	switch (cells_grid->words_per_row) {
+		case 1:   return step_tile_row_1;
+		case 2:   return step_tile_row_2;
+		case 4:   return step_tile_row_4;
+		case 8:   return step_tile_row_8;
+		case 16:  return step_tile_row_16;
+		case 32:  return step_tile_row_32;
+		case 64:  return step_tile_row_64;
+		case 128: return step_tile_row_128;
+		case 256: return step_tile_row_256;
+		default:  return step_tile_row_generic;
+	}
+}
+
+// Cools every tile and heats the changed ones. Cooling rounds up, so a tile that stopped changing gets back to 0
+static void heat_tiles(CellsGrid* cells_grid) {
+	if (cells_grid->tile_heat == NULL) {
+		return;
+	}
+
+	for (size_t tile = 0; tile < cells_grid->tiles_x * cells_grid->tiles_y; ++tile) {
+		Uint16 heat = cells_grid->tile_heat[tile];
+		heat -= (heat + (1 << CELLS_HEAT_SHIFT) - 1) >> CELLS_HEAT_SHIFT;
+		cells_grid->tile_heat[tile] = heat + (cells_grid->tile_changed[tile] ? CELLS_HEAT_UNIT : 0);
+	}
+}
+
+void CellsGrid_step(CellsGrid* cells_grid) {
+	size_t words = cells_grid->words_per_row;
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	size_t last_tile_y = cells_grid->tiles_y - 1;
+
+	// Births from nothing turn empty space on, so nothing can be skipped
+	if (cells_grid->rule.birth & 1) {
+		memset(cells_grid->tile_active, 1, tiles);
+	}
+
+	// Save unmodified rows bordering every tile row before any of them gets overwritten
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		size_t span_count = find_spans(cells_grid, tile_y);
+		const CellsWord* row_above = CellsGrid_row(cells_grid, (tile_y * CELLS_TILE_ROWS + cells_grid->height - 1) % cells_grid->height);
+
+		for (size_t s = 0; s < span_count; s += 2) {
+			copy_span(cells_grid->halo + tile_y * words, row_above, cells_grid->spans[s], cells_grid->spans[s + 1], words);
+			if (tile_y == last_tile_y) {
+				copy_span(cells_grid->row_buffers + 2 * words, CellsGrid_row(cells_grid, 0), cells_grid->spans[s], cells_grid->spans[s + 1], words);
+			}
+		}
+	}
+
+	StepTileRowFunction step_tile_row_kernel = pick_kernel(cells_grid);
+	cells_grid->stepped_tiles = 0;
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		size_t span_count = find_spans(cells_grid, tile_y);
+		if (span_count > 0) {
+			step_tile_row_kernel(cells_grid, tile_y, span_count);
+		}
+		for (size_t s = 0; s < span_count; s += 2) {
+			cells_grid->stepped_tiles += cells_grid->spans[s + 1] - cells_grid->spans[s];
+		}
+	}
+
+	// Next time only tiles next to a change can change
+	memset(cells_grid->tile_active, 0, tiles);
+	++cells_grid->modification;
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		for (size_t tile_x = 0; tile_x < cells_grid->tiles_x; ++tile_x) {
+			size_t tile = tile_y * cells_grid->tiles_x + tile_x;
+			if (cells_grid->tile_changed[tile]) {
+				activate_around(cells_grid, tile_x, tile_y);
+				cells_grid->tile_modification[tile] = cells_grid->modification;
+				cells_grid->tile_row_modification[tile_y] = cells_grid->modification;
+			}
+		}
+	}
+
+	heat_tiles(cells_grid);
+	memset(cells_grid->tile_changed, 0, tiles);
+
+	++cells_grid->generation;
+}
+
+void CellsGrid_update_heat(CellsGrid* cells_grid) {
+	heat_tiles(cells_grid);
+	memset(cells_grid->tile_changed, 0, cells_grid->tiles_x * cells_grid->tiles_y);
 }
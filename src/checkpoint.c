@@ -0,0 +1,438 @@
+#include "../include/checkpoint.h"
+#include "../include/runs.h"
+
+static const char CHECKPOINT_MAGIC[8] = "GOLCKPT";
+static const Uint32 CHECKPOINT_VERSION = 1;
+static const Uint32 CHECKPOINT_BYTE_ORDER = 0x01020304;  // reads differently on a host of the other endianness
+
+// Written as is, every field is naturally aligned so there is no padding. It's followed by the compressed
+// size of every cell band, then if ages are tracked by the compressed size of every age band and the per tile
+// age generations, then by the cell bands and the age bands themselves
+typedef struct CheckpointHeaderStruct {
+	char magic[8];
+	Uint32 version;
+	Uint32 byte_order;
+	Uint64 width, height;
+	Uint64 generation;
+	Uint64 random_state;
+	Uint32 band_rows;
+	Uint32 has_age;
+	char rule[32];
+} CheckpointHeader;
+
+// Bands are run-length coded, a band that wouldn't get smaller is stored raw, which is told apart by its
+// size being the raw one
+static int decompress_words(const Uint8* in, size_t size, CellsWord* words, size_t count) {
+	if (size == count * sizeof(CellsWord)) {
+		memcpy(words, in, size);
+		return 0;
+	}
+
+	// Words start out zeroed
+	return Runs_decode_words(in, in + size, words, count, 0) == in + size ? 0 : -1;
+}
+
+static int decompress_bytes(const Uint8* in, size_t size, Uint8* bytes, size_t count) {
+	if (size == count) {
+		memcpy(bytes, in, size);
+		return 0;
+	}
+
+	return Runs_decode_bytes(in, in + size, bytes, count) == in + size ? 0 : -1;
+}
+
+// Work shared by the band threads, each takes the next band until none are left
+typedef struct BandJobStruct {
+	CellsGrid* cells_grid;
+	Checkpoint* checkpoint;
+	SDL_atomic_t next_band;
+	SDL_atomic_t failed;
+} BandJob;
+
+static void band_rows(const Checkpoint* checkpoint, size_t band, size_t* y0, size_t* y1) {
+	*y0 = band * CELLS_TILE_ROWS;
+	*y1 = SDL_min(*y0 + CELLS_TILE_ROWS, (size_t)checkpoint->height);
+}
+
+// Compresses into a buffer of the raw size, falling back to a raw copy, and trims it
+static Uint8* compress_band(const void* raw, size_t raw_size, int is_words, Uint64* size) {
+	Uint8* out = malloc(raw_size);
+	if (out == NULL) {
+		return NULL;
+	}
+
+	size_t length = is_words ? Runs_encode_words(raw, raw_size / sizeof(CellsWord), out, raw_size - 1)
+							 : Runs_encode_bytes(raw, raw_size, out, raw_size - 1);
+	if (length == 0) {
+		memcpy(out, raw, raw_size);
+		length = raw_size;
+	}
+
+	Uint8* trimmed = realloc(out, length);
+	*size = length;
+	return trimmed != NULL ? trimmed : out;
+}
+
+static int capture_bands(void* data) {
+	BandJob* job = data;
+	const CellsGrid* cells_grid = job->cells_grid;
+	Checkpoint* checkpoint = job->checkpoint;
+
+	for (size_t band = SDL_AtomicAdd(&job->next_band, 1); band < checkpoint->band_count && !SDL_AtomicGet(&job->failed);
+		 band = SDL_AtomicAdd(&job->next_band, 1)) {
+		size_t y0, y1;
+		band_rows(checkpoint, band, &y0, &y1);
+
+		checkpoint->bands[band] = compress_band(CellsGrid_row(cells_grid, y0), (y1 - y0) * cells_grid->words_per_row * sizeof(CellsWord),
+												1, &checkpoint->band_sizes[band]);
+		if (checkpoint->bands[band] == NULL) {
+			SDL_AtomicSet(&job->failed, 1);
+			break;
+		}
+
+		if (checkpoint->age_bands != NULL) {
+			checkpoint->age_bands[band] = compress_band(cells_grid->age + y0 * cells_grid->width, (y1 - y0) * cells_grid->width,
+														0, &checkpoint->age_band_sizes[band]);
+			if (checkpoint->age_bands[band] == NULL) {
+				SDL_AtomicSet(&job->failed, 1);
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int restore_bands(void* data) {
+	BandJob* job = data;
+	CellsGrid* cells_grid = job->cells_grid;
+	const Checkpoint* checkpoint = job->checkpoint;
+
+	for (size_t band = SDL_AtomicAdd(&job->next_band, 1); band < checkpoint->band_count && !SDL_AtomicGet(&job->failed);
+		 band = SDL_AtomicAdd(&job->next_band, 1)) {
+		size_t y0, y1;
+		band_rows(checkpoint, band, &y0, &y1);
+
+		int failed = decompress_words(checkpoint->bands[band], checkpoint->band_sizes[band], CellsGrid_row(cells_grid, y0),
+									  (y1 - y0) * cells_grid->words_per_row) != 0;
+		if (!failed && checkpoint->age_bands != NULL) {
+			failed = decompress_bytes(checkpoint->age_bands[band], checkpoint->age_band_sizes[band],
+									  cells_grid->age + y0 * cells_grid->width, (y1 - y0) * cells_grid->width) != 0;
+		}
+		if (failed) {
+			SDL_AtomicSet(&job->failed, 1);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+// Runs the job on every core, the calling thread included. Bands left by threads that failed to start are
+// picked up by the others
+static int run_bands(SDL_ThreadFunction function, BandJob* job) {
+	enum {MAX_THREADS = 64};
+	SDL_Thread* threads[MAX_THREADS];
+	int thread_count = SDL_min(SDL_min(SDL_GetCPUCount(), MAX_THREADS), (int)job->checkpoint->band_count) - 1;
+
+	int started = 0;
+	for (; started < thread_count; ++started) {
+		threads[started] = SDL_CreateThread(function, "checkpoint", job);
+		if (threads[started] == NULL) {
+			break;
+		}
+	}
+
+	function(job);
+	for (int i = 0; i < started; ++i) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	return SDL_AtomicGet(&job->failed) ? -1 : 0;
+}
+
+static Checkpoint* allocate_checkpoint(size_t height, size_t tiles, int has_age) {
+	Checkpoint* checkpoint = calloc(1, sizeof(Checkpoint));
+	if (checkpoint == NULL) {
+		return NULL;
+	}
+
+	checkpoint->band_count = (height + CELLS_TILE_ROWS - 1) / CELLS_TILE_ROWS;
+	checkpoint->bands = calloc(checkpoint->band_count, sizeof(Uint8*));
+	checkpoint->band_sizes = calloc(checkpoint->band_count, sizeof(Uint64));
+	int failed = checkpoint->bands == NULL || checkpoint->band_sizes == NULL;
+	if (has_age) {
+		checkpoint->age_bands = calloc(checkpoint->band_count, sizeof(Uint8*));
+		checkpoint->age_band_sizes = calloc(checkpoint->band_count, sizeof(Uint64));
+		checkpoint->age_generation = malloc(sizeof(Uint64) * tiles);
+		failed = failed || checkpoint->age_bands == NULL || checkpoint->age_band_sizes == NULL || checkpoint->age_generation == NULL;
+	}
+
+	if (failed) {
+		Checkpoint_delete(checkpoint);
+		return NULL;
+	}
+
+	return checkpoint;
+}
+
+Checkpoint* Checkpoint_capture(const CellsGrid* cells_grid) {
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	Checkpoint* checkpoint = allocate_checkpoint(cells_grid->height, tiles, cells_grid->age != NULL);
+	if (checkpoint == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for checkpoint\n");
+		return NULL;
+	}
+
+	checkpoint->width = cells_grid->width;
+	checkpoint->height = cells_grid->height;
+	checkpoint->generation = cells_grid->generation;
+	checkpoint->random_state = cells_grid->random_state;
+	checkpoint->rule = cells_grid->rule;
+	if (cells_grid->age != NULL) {
+		memcpy(checkpoint->age_generation, cells_grid->age_generation, sizeof(Uint64) * tiles);
+	}
+
+	// Workers only read the grid
+	BandJob job = {(CellsGrid*)cells_grid, checkpoint, {0}, {0}};
+	if (run_bands(capture_bands, &job) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for checkpoint bands\n");
+		Checkpoint_delete(checkpoint);
+		return NULL;
+	}
+
+	return checkpoint;
+}
+
+void Checkpoint_delete(Checkpoint* checkpoint) {
+	for (size_t i = 0; i < checkpoint->band_count; ++i) {
+		if (checkpoint->bands != NULL) {
+			free(checkpoint->bands[i]);
+		}
+		if (checkpoint->age_bands != NULL) {
+			free(checkpoint->age_bands[i]);
+		}
+	}
+
+	free(checkpoint->bands);
+	free(checkpoint->band_sizes);
+	free(checkpoint->age_bands);
+	free(checkpoint->age_band_sizes);
+	free(checkpoint->age_generation);
+	free(checkpoint);
+}
+
+int Checkpoint_write(const Checkpoint* checkpoint, const char* path) {
+	CheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+	header.version = CHECKPOINT_VERSION;
+	header.byte_order = CHECKPOINT_BYTE_ORDER;
+	header.width = checkpoint->width;
+	header.height = checkpoint->height;
+	header.generation = checkpoint->generation;
+	header.random_state = checkpoint->random_state;
+	header.band_rows = CELLS_TILE_ROWS;
+	header.has_age = checkpoint->age_bands != NULL;
+	Rule_format(checkpoint->rule, header.rule, sizeof(header.rule));
+
+	char temp_path[1024];
+	if ((size_t)snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= sizeof(temp_path)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Checkpoint path '%s' is too long\n", path);
+		return -1;
+	}
+
+	FILE* file = fopen(temp_path, "wb");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' for writing\n", temp_path);
+		return -1;
+	}
+
+	size_t bands = checkpoint->band_count;
+	size_t tiles = (checkpoint->width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS * bands;
+	int failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+				 fwrite(checkpoint->band_sizes, sizeof(Uint64), bands, file) != bands;
+	if (header.has_age) {
+		failed = failed || fwrite(checkpoint->age_band_sizes, sizeof(Uint64), bands, file) != bands ||
+				 fwrite(checkpoint->age_generation, sizeof(Uint64), tiles, file) != tiles;
+	}
+	for (size_t i = 0; !failed && i < bands; ++i) {
+		failed = fwrite(checkpoint->bands[i], 1, checkpoint->band_sizes[i], file) != checkpoint->band_sizes[i];
+	}
+	for (size_t i = 0; !failed && header.has_age && i < bands; ++i) {
+		failed = fwrite(checkpoint->age_bands[i], 1, checkpoint->age_band_sizes[i], file) != checkpoint->age_band_sizes[i];
+	}
+
+	failed = fclose(file) != 0 || failed;
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write checkpoint '%s'\n", temp_path);
+		remove(temp_path);
+		return -1;
+	}
+
+#ifdef _WIN32
+	// rename() doesn't replace existing files on Windows
+	remove(path);
+#endif
+	if (rename(temp_path, path) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to replace checkpoint '%s'\n", path);
+		remove(temp_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int read_header(FILE* file, const char* path, CheckpointHeader* header) {
+	const char* error = NULL;
+	if (fread(header, sizeof(*header), 1, file) != 1 || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0) {
+		error = "not a checkpoint";
+	}
+	else if (header->version != CHECKPOINT_VERSION || header->band_rows != CELLS_TILE_ROWS) {
+		error = "unsupported version";
+	}
+	else if (header->byte_order != CHECKPOINT_BYTE_ORDER) {
+		error = "saved on a machine of different byte order";
+	}
+	else if (header->width == 0 || header->height == 0 || header->width > SIZE_MAX / header->height) {
+		error = "invalid dimensions";
+	}
+
+	if (error != NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load checkpoint '%s': %s\n", path, error);
+		return -1;
+	}
+
+	header->rule[sizeof(header->rule) - 1] = '\0';
+	return 0;
+}
+
+int Checkpoint_peek(const char* path, size_t* width, size_t* height) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open checkpoint '%s'\n", path);
+		return -1;
+	}
+
+	CheckpointHeader header;
+	int result = read_header(file, path, &header);
+	fclose(file);
+	if (result != 0) {
+		return -1;
+	}
+
+	*width = header.width;
+	*height = header.height;
+	return 0;
+}
+
+// Reads every band into memory, they're decompressed in parallel afterwards
+static Checkpoint* read_checkpoint(FILE* file, const char* path) {
+	CheckpointHeader header;
+	if (read_header(file, path, &header) != 0) {
+		return NULL;
+	}
+
+	size_t tiles = (header.width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS * ((header.height + CELLS_TILE_ROWS - 1) / CELLS_TILE_ROWS);
+	Checkpoint* checkpoint = allocate_checkpoint(header.height, tiles, header.has_age);
+	if (checkpoint == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for checkpoint\n");
+		return NULL;
+	}
+
+	checkpoint->width = header.width;
+	checkpoint->height = header.height;
+	checkpoint->generation = header.generation;
+	checkpoint->random_state = header.random_state;
+
+	size_t bands = checkpoint->band_count;
+	const char* error = NULL;
+	if (Rule_parse(header.rule, &checkpoint->rule) != 0) {
+		error = "invalid rule";
+	}
+	else if (fread(checkpoint->band_sizes, sizeof(Uint64), bands, file) != bands ||
+			 (header.has_age && (fread(checkpoint->age_band_sizes, sizeof(Uint64), bands, file) != bands ||
+								 fread(checkpoint->age_generation, sizeof(Uint64), tiles, file) != tiles))) {
+		error = "truncated";
+	}
+
+	for (int ages = 0; error == NULL && ages <= (header.has_age != 0); ++ages) {
+		Uint8** data = ages ? checkpoint->age_bands : checkpoint->bands;
+		Uint64* sizes = ages ? checkpoint->age_band_sizes : checkpoint->band_sizes;
+		for (size_t i = 0; error == NULL && i < bands; ++i) {
+			// A compressed band is never bigger than the raw one
+			size_t rows = SDL_min((size_t)CELLS_TILE_ROWS, (size_t)header.height - i * CELLS_TILE_ROWS);
+			size_t raw_size = ages ? rows * header.width : rows * ((header.width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS) * sizeof(CellsWord);
+			if (sizes[i] == 0 || sizes[i] > raw_size) {
+				error = "corrupted band sizes";
+				break;
+			}
+
+			data[i] = malloc(sizes[i]);
+			if (data[i] == NULL) {
+				error = "out of memory";
+			}
+			else if (fread(data[i], 1, sizes[i], file) != sizes[i]) {
+				error = "truncated";
+			}
+		}
+	}
+
+	if (error != NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load checkpoint '%s': %s\n", path, error);
+		Checkpoint_delete(checkpoint);
+		return NULL;
+	}
+
+	return checkpoint;
+}
+
+CellsGrid* Checkpoint_load(const char* path, unsigned int cell_size) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open checkpoint '%s'\n", path);
+		return NULL;
+	}
+
+	Checkpoint* checkpoint = read_checkpoint(file, path);
+	fclose(file);
+	if (checkpoint == NULL) {
+		return NULL;
+	}
+
+	// Zeroed pages of empty bands are never touched
+	size_t words = (checkpoint->width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS * checkpoint->height;
+	CellsWord* cells = calloc(words, sizeof(CellsWord));
+	CellsGrid* cells_grid = cells != NULL ? CellsGrid_create_mapped(checkpoint->width, checkpoint->height, cell_size, cells, NULL, 0) : NULL;
+	if (cells_grid == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for %llux%llu cells\n",
+					 (unsigned long long)checkpoint->width, (unsigned long long)checkpoint->height);
+		free(cells);
+		Checkpoint_delete(checkpoint);
+		return NULL;
+	}
+
+	cells_grid->rule = checkpoint->rule;
+	cells_grid->generation = checkpoint->generation;
+	cells_grid->random_state = checkpoint->random_state;
+
+	int result = checkpoint->age_bands != NULL ? CellsGrid_set_age_tracking(cells_grid, 1) : 0;
+	if (result == 0) {
+		BandJob job = {cells_grid, checkpoint, {0}, {0}};
+		result = run_bands(restore_bands, &job);
+		if (result != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load checkpoint '%s': corrupted band\n", path);
+		}
+	}
+	if (result == 0 && checkpoint->age_bands != NULL) {
+		memcpy(cells_grid->age_generation, checkpoint->age_generation, sizeof(Uint64) * cells_grid->tiles_x * cells_grid->tiles_y);
+	}
+
+	Checkpoint_delete(checkpoint);
+	if (result != 0) {
+		CellsGrid_delete(cells_grid);
+		return NULL;
+	}
+
+	return cells_grid;
+}
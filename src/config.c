@@ -0,0 +1,340 @@
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include "../include/config.h"
+
+// Biggest board side, keeps width * height and the packed row stride well inside size_t
+static const unsigned long long GRID_SIDE_MAX = 1ull << 24;
+static const unsigned long long CELL_SIZE_MAX = 64;
+static const unsigned long long CHECKPOINT_INTERVAL_MAX = 7 * 24 * 60 * 60;
+static const unsigned long long HISTORY_BUDGET_MAX = 1ull << 20;  // in megabytes
+static const unsigned long long VIDEO_FRAMES_MAX = 1ull << 24;
+static const unsigned long long VIDEO_EVERY_MAX = 1ull << 20;
+static const unsigned long long BRUSH_RADIUS_MAX = 1024;
+
+void Config_init(Config* config) {
+	config->grid_width = 128;
+	config->grid_height = 91;
+	config->cell_size = 8;
+	config->fade = 1;
+	config->rule = RULE_CONWAY;
+	config->load_path[0] = '\0';
+	SDL_strlcpy(config->save_path, "board.grid", sizeof(config->save_path));
+	config->pattern_path[0] = '\0';
+	config->pattern_centered = 1;
+	config->pattern_x = config->pattern_y = 0;
+	SDL_strlcpy(config->export_path, "board.rle", sizeof(config->export_path));
+	SDL_strlcpy(config->screenshot_path, "board.png", sizeof(config->screenshot_path));
+	SDL_strlcpy(config->checkpoint_path, "board.ckpt", sizeof(config->checkpoint_path));
+	config->checkpoint_interval = 0;
+	config->history_budget = 64;
+	config->record_path[0] = '\0';
+	config->play_path[0] = '\0';
+	config->seeded = 0;
+	config->seed = 0;
+	config->video_path[0] = '\0';
+	config->video_frames = 300;
+	config->video_every = 1;
+	config->brush_radius = 0;
+	config->verbose = 0;
+}
+
+static int parse_number(const char* text, unsigned long long min, unsigned long long max, unsigned long long* result) {
+	char* end;
+	errno = 0;
+	unsigned long long value = strtoull(text, &end, 10);
+	if (errno != 0 || end == text || *end != '\0' || text[0] == '-' || value < min || value > max) {
+		return -1;
+	}
+
+	*result = value;
+	return 0;
+}
+
+static int parse_signed_number(const char* text, long long* result) {
+	char* end;
+	errno = 0;
+	long long value = strtoll(text, &end, 10);
+	if (errno != 0 || end == text || *end != '\0') {
+		return -1;
+	}
+
+	*result = value;
+	return 0;
+}
+
+static int set_path(char* path, const char* value) {
+	if (SDL_strlcpy(path, value, CONFIG_PATH_MAX) >= CONFIG_PATH_MAX) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Path '%s' is too long\n", value);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Sets a single option, keys are the same for config files and command line (without leading dashes)
+static int set_option(Config* config, const char* key, const char* value) {
+	unsigned long long number;
+
+	if (strcmp(key, "width") == 0) {
+		if (parse_number(value, 1, GRID_SIDE_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Grid width must be between 1 and %llu, got '%s'\n", GRID_SIDE_MAX, value);
+			return -1;
+		}
+		config->grid_width = number;
+	}
+	else if (strcmp(key, "height") == 0) {
+		if (parse_number(value, 1, GRID_SIDE_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Grid height must be between 1 and %llu, got '%s'\n", GRID_SIDE_MAX, value);
+			return -1;
+		}
+		config->grid_height = number;
+	}
+	else if (strcmp(key, "cell-size") == 0) {
+		if (parse_number(value, 1, CELL_SIZE_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cell size must be between 1 and %llu, got '%s'\n", CELL_SIZE_MAX, value);
+			return -1;
+		}
+		config->cell_size = number;
+	}
+	else if (strcmp(key, "fade") == 0) {
+		if (parse_number(value, 0, 1, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Fade must be 0 or 1, got '%s'\n", value);
+			return -1;
+		}
+		config->fade = number;
+	}
+	else if (strcmp(key, "rule") == 0) {
+		if (Rule_parse(value, &config->rule) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Rule must look like B3/S23, got '%s'\n", value);
+			return -1;
+		}
+	}
+	else if (strcmp(key, "load") == 0) {
+		return set_path(config->load_path, value);
+	}
+	else if (strcmp(key, "save") == 0) {
+		return set_path(config->save_path, value);
+	}
+	else if (strcmp(key, "pattern") == 0) {
+		return set_path(config->pattern_path, value);
+	}
+	else if (strcmp(key, "export") == 0) {
+		return set_path(config->export_path, value);
+	}
+	else if (strcmp(key, "screenshot") == 0) {
+		return set_path(config->screenshot_path, value);
+	}
+	else if (strcmp(key, "checkpoint") == 0) {
+		return set_path(config->checkpoint_path, value);
+	}
+	else if (strcmp(key, "checkpoint-interval") == 0) {
+		if (parse_number(value, 0, CHECKPOINT_INTERVAL_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Checkpoint interval must be between 0 and %llu seconds, got '%s'\n", CHECKPOINT_INTERVAL_MAX, value);
+			return -1;
+		}
+		config->checkpoint_interval = number;
+	}
+	else if (strcmp(key, "history") == 0) {
+		if (parse_number(value, 0, HISTORY_BUDGET_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "History budget must be between 0 and %llu megabytes, got '%s'\n", HISTORY_BUDGET_MAX, value);
+			return -1;
+		}
+		config->history_budget = number;
+	}
+	else if (strcmp(key, "record") == 0) {
+		return set_path(config->record_path, value);
+	}
+	else if (strcmp(key, "play") == 0) {
+		return set_path(config->play_path, value);
+	}
+	else if (strcmp(key, "seed") == 0) {
+		if (parse_number(value, 0, ULLONG_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Seed must be a non-negative number, got '%s'\n", value);
+			return -1;
+		}
+		config->seeded = 1;
+		config->seed = number;
+	}
+	else if (strcmp(key, "video") == 0) {
+		return set_path(config->video_path, value);
+	}
+	else if (strcmp(key, "video-frames") == 0) {
+		if (parse_number(value, 1, VIDEO_FRAMES_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Video frames must be between 1 and %llu, got '%s'\n", VIDEO_FRAMES_MAX, value);
+			return -1;
+		}
+		config->video_frames = number;
+	}
+	else if (strcmp(key, "video-every") == 0) {
+		if (parse_number(value, 1, VIDEO_EVERY_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Generations per video frame must be between 1 and %llu, got '%s'\n", VIDEO_EVERY_MAX, value);
+			return -1;
+		}
+		config->video_every = number;
+	}
+	else if (strcmp(key, "brush") == 0) {
+		if (parse_number(value, 0, BRUSH_RADIUS_MAX, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Brush radius must be between 0 and %llu cells, got '%s'\n", BRUSH_RADIUS_MAX, value);
+			return -1;
+		}
+		config->brush_radius = number;
+	}
+	else if (strcmp(key, "verbose") == 0) {
+		if (parse_number(value, 0, 1, &number) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Verbose must be 0 or 1, got '%s'\n", value);
+			return -1;
+		}
+		config->verbose = number;
+	}
+	else if (strcmp(key, "pattern-x") == 0 || strcmp(key, "pattern-y") == 0) {
+		long long* coordinate = key[8] == 'x' ? &config->pattern_x : &config->pattern_y;
+		if (parse_signed_number(value, coordinate) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pattern position must be a number, got '%s'\n", value);
+			return -1;
+		}
+		config->pattern_centered = 0;
+	}
+	else {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown option '%s'\n", key);
+		return -1;
+	}
+
+	return 0;
+}
+
+static char* trim(char* text) {
+	while (isspace((unsigned char)*text)) {
+		++text;
+	}
+
+	char* end = text + strlen(text);
+	while (end > text && isspace((unsigned char)end[-1])) {
+		--end;
+	}
+	*end = '\0';
+
+	return text;
+}
+
+int Config_load_file(Config* config, const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open config file '%s'\n", path);
+		return -1;
+	}
+
+	char line[256];
+	unsigned int line_number = 0;
+	int result = 0;
+	while (result == 0 && fgets(line, sizeof(line), file) != NULL) {
+		++line_number;
+
+		char* comment = strchr(line, '#');
+		if (comment != NULL) {
+			*comment = '\0';
+		}
+
+		char* key = trim(line);
+		if (*key == '\0') {
+			continue;
+		}
+
+		char* separator = strchr(key, '=');
+		if (separator == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s:%u: expected 'key = value'\n", path, line_number);
+			result = -1;
+			break;
+		}
+		*separator = '\0';
+
+		// Underscores are accepted in files, as in "cell_size = 4"
+		key = trim(key);
+		for (char* c = key; *c != '\0'; ++c) {
+			if (*c == '_') {
+				*c = '-';
+			}
+		}
+
+		if (set_option(config, key, trim(separator + 1)) != 0) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s:%u: invalid setting\n", path, line_number);
+			result = -1;
+		}
+	}
+
+	fclose(file);
+	return result;
+}
+
+int Config_parse_args(Config* config, int argc, char* argv[]) {
+	// Config file goes first so options given next to it take precedence
+	for (int i = 1; i < argc - 1; ++i) {
+		if (strcmp(argv[i], "--config") == 0 && Config_load_file(config, argv[i + 1]) != 0) {
+			return -1;
+		}
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+			Config_print_usage(argv[0]);
+			return 1;
+		}
+		if (strcmp(arg, "--no-fade") == 0) {
+			config->fade = 0;
+			continue;
+		}
+		if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
+			config->verbose = 1;
+			continue;
+		}
+		if (strncmp(arg, "--", 2) != 0 || i + 1 >= argc) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unexpected argument '%s'\n", arg);
+			Config_print_usage(argv[0]);
+			return -1;
+		}
+
+		const char* value = argv[++i];
+		if (strcmp(arg, "--config") == 0) {
+			continue;
+		}
+		if (set_option(config, arg + 2, value) != 0) {
+			Config_print_usage(argv[0]);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void Config_print_usage(const char* program_name) {
+	printf("Usage: %s [options]\n"
+	       "  --config FILE     read options from FILE (\"width = 1024\" per line)\n"
+	       "  --width N         number of cells in a row\n"
+	       "  --height N        number of cells in a column\n"
+	       "  --cell-size N     size of a cell in pixels\n"
+	       "  --fade 0|1        color cells by the time since their last change\n"
+	       "  --no-fade         same as --fade 0\n"
+	       "  --rule RULE       birth/survival rule, e.g. B3/S23 or B36/S23\n"
+	       "  --load FILE       start from a grid file or .ckpt checkpoint (size and rule come from the file)\n"
+	       "  --save FILE       where S saves the grid (board.grid by default)\n"
+	       "  --pattern FILE    start from an RLE or .mc pattern on an empty board, centered\n"
+	       "  --pattern-x N     put the pattern's left edge at column N instead\n"
+	       "  --pattern-y N     put the pattern's top edge at row N instead\n"
+	       "  --export FILE     where X exports the board, .mc for macrocell (board.rle by default)\n"
+	       "  --screenshot FILE where I saves an image of the board, .bmp for BMP (board.png by default)\n"
+	       "  --checkpoint FILE where K writes a checkpoint (board.ckpt by default)\n"
+	       "  --checkpoint-interval N  also write one every N seconds, 0 for never\n"
+	       "  --history N       megabytes kept for rewinding with Backspace (64 by default), 0 for none\n"
+	       "  --brush N         paint cells within N of the cursor (0 by default, just the one under it)\n"
+	       "  --record FILE     record every generation to FILE\n"
+	       "  --play FILE       play a recording back instead of simulating (size and rule come from the file)\n"
+	       "  --seed N          randomize boards from N instead of the time, runs with the same seed match exactly\n"
+	       "  --video FILE      render frames into FILE without a window and quit, .y4m for Y4M, else a PPM stream\n"
+	       "  --video-frames N  number of frames to render (300 by default)\n"
+	       "  --video-every N   generations between frames (1 by default), frames are --cell-size pixels per cell\n"
+	       "  -v, --verbose     log timings, such as how long startup took\n"
+	       "  -h, --help        show this message\n",
+	       program_name);
+}
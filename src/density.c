@@ -0,0 +1,140 @@
+#include "../include/density.h"
+
+// Base blocks across a tile, tiles are CELLS_WORD_BITS cells by CELLS_TILE_ROWS rows
+#define TILE_BLOCKS (CELLS_WORD_BITS / DENSITY_BASE_BLOCK)
+
+// Recounts the base blocks of a tile from its words
+static void count_tile(DensityPyramid* pyramid, const CellsGrid* cells_grid, size_t tile_x, size_t tile_y) {
+	size_t width = pyramid->widths[0];
+	size_t block_x = tile_x * TILE_BLOCKS, blocks = SDL_min((size_t)TILE_BLOCKS, width - block_x);
+	size_t y0 = tile_y * CELLS_TILE_ROWS, y1 = SDL_min(y0 + CELLS_TILE_ROWS, cells_grid->height);
+
+	for (size_t y = y0; y < y1; y += DENSITY_BASE_BLOCK) {
+		Uint32* counts = pyramid->counts[0] + (y / DENSITY_BASE_BLOCK) * width + block_x;
+		Uint32 sums[TILE_BLOCKS] = {0};
+		for (size_t row = y; row < SDL_min(y + DENSITY_BASE_BLOCK, y1); ++row) {
+			CellsWord word = CellsGrid_row(cells_grid, row)[tile_x];
+			for (int i = 0; i < TILE_BLOCKS; ++i, word >>= DENSITY_BASE_BLOCK) {
+				sums[i] += __builtin_popcountll(word & (((CellsWord)1 << DENSITY_BASE_BLOCK) - 1));
+			}
+		}
+		for (size_t i = 0; i < blocks; ++i) {
+			counts[i] = sums[i];
+		}
+	}
+}
+
+// Sets a block of a level above the base to the sum of the (up to) four below it. Blocks of 65536 cells a side
+// hold 2^32 of them, so sums saturate rather than wrap a full block around to empty
+static void sum_block(DensityPyramid* pyramid, int level, size_t x, size_t y) {
+	const Uint32* below = pyramid->counts[level - 1];
+	size_t width = pyramid->widths[level - 1], height = pyramid->heights[level - 1];
+	size_t x1 = SDL_min(2 * x + 2, width), y1 = SDL_min(2 * y + 2, height);
+
+	Uint64 sum = 0;
+	for (size_t j = 2 * y; j < y1; ++j) {
+		for (size_t i = 2 * x; i < x1; ++i) {
+			sum += below[j * width + i];
+		}
+	}
+	pyramid->counts[level][y * pyramid->widths[level] + x] = (Uint32)SDL_min(sum, (Uint64)SDL_MAX_UINT32);
+}
+
+DensityPyramid* DensityPyramid_create(const CellsGrid* cells_grid) {
+	DensityPyramid* pyramid = calloc(1, sizeof(DensityPyramid));
+	if (pyramid == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for density pyramid\n");
+		return NULL;
+	}
+
+	// Levels halve the block counts down to a single block
+	size_t width = (cells_grid->width + DENSITY_BASE_BLOCK - 1) / DENSITY_BASE_BLOCK;
+	size_t height = (cells_grid->height + DENSITY_BASE_BLOCK - 1) / DENSITY_BASE_BLOCK;
+	int level_count = 1;
+	for (size_t w = width, h = height; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2) {
+		++level_count;
+	}
+
+	pyramid->widths = malloc(sizeof(size_t) * level_count);
+	pyramid->heights = malloc(sizeof(size_t) * level_count);
+	pyramid->counts = calloc(level_count, sizeof(Uint32*));
+	if (pyramid->widths == NULL || pyramid->heights == NULL || pyramid->counts == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for density pyramid\n");
+		DensityPyramid_delete(pyramid);
+		return NULL;
+	}
+	pyramid->level_count = level_count;
+
+	for (int level = 0; level < level_count; ++level) {
+		pyramid->widths[level] = width;
+		pyramid->heights[level] = height;
+		pyramid->counts[level] = malloc(sizeof(Uint32) * width * height);
+		if (pyramid->counts[level] == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for density pyramid\n");
+			DensityPyramid_delete(pyramid);
+			return NULL;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	// Counted whole, every block of every level once
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		for (size_t tile_x = 0; tile_x < cells_grid->tiles_x; ++tile_x) {
+			count_tile(pyramid, cells_grid, tile_x, tile_y);
+		}
+	}
+	for (int level = 1; level < level_count; ++level) {
+		for (size_t y = 0; y < pyramid->heights[level]; ++y) {
+			for (size_t x = 0; x < pyramid->widths[level]; ++x) {
+				sum_block(pyramid, level, x, y);
+			}
+		}
+	}
+	pyramid->modification = cells_grid->modification;
+
+	return pyramid;
+}
+
+void DensityPyramid_delete(DensityPyramid* pyramid) {
+	if (pyramid->counts != NULL) {
+		for (int level = 0; level < pyramid->level_count; ++level) {
+			free(pyramid->counts[level]);
+		}
+	}
+	free(pyramid->counts);
+	free(pyramid->widths);
+	free(pyramid->heights);
+	free(pyramid);
+}
+
+void DensityPyramid_update(DensityPyramid* pyramid, const CellsGrid* cells_grid) {
+	if (cells_grid->modification == pyramid->modification) {
+		return;
+	}
+
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		for (size_t tile_x = 0; tile_x < cells_grid->tiles_x; ++tile_x) {
+			if (cells_grid->tile_modification[tile_y * cells_grid->tiles_x + tile_x] <= pyramid->modification) {
+				continue;
+			}
+			count_tile(pyramid, cells_grid, tile_x, tile_y);
+
+			// Blocks above it, within the tile at first and then one per level. Ones shared with other changed
+			// tiles get summed again, which costs less than tracking them
+			size_t x0 = tile_x * TILE_BLOCKS, x1 = x0 + TILE_BLOCKS - 1;
+			size_t y0 = tile_y * (CELLS_TILE_ROWS / DENSITY_BASE_BLOCK), y1 = y0 + CELLS_TILE_ROWS / DENSITY_BASE_BLOCK - 1;
+			for (int level = 1; level < pyramid->level_count; ++level) {
+				size_t last_x = SDL_min(x1 >> level, pyramid->widths[level] - 1);
+				size_t last_y = SDL_min(y1 >> level, pyramid->heights[level] - 1);
+				for (size_t y = y0 >> level; y <= last_y; ++y) {
+					for (size_t x = x0 >> level; x <= last_x; ++x) {
+						sum_block(pyramid, level, x, y);
+					}
+				}
+			}
+		}
+	}
+
+	pyramid->modification = cells_grid->modification;
+}
@@ -0,0 +1,60 @@
+#include "../include/font.h"
+#include "../include/resources.h"
+
+FC_Font* Font_load_atlas(SDL_Renderer* renderer, SDL_RWops* rw) {
+	FontAtlasHeader header;
+	if (SDL_RWread(rw, &header, sizeof(header), 1) != 1 || memcmp(header.magic, FONT_ATLAS_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != FONT_ATLAS_VERSION || header.byte_order != FONT_ATLAS_BYTE_ORDER || header.size != FONT_SIZE) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Font atlas is invalid or was baked for another build\n");
+		return NULL;
+	}
+
+	SDL_Surface* image = SDL_LoadBMP_RW(rw, 0);
+	if (image == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read font atlas image: %s\n", SDL_GetError());
+		return NULL;
+	}
+
+	FC_Font* font = FC_CreateFont();
+	if (!FC_LoadFontFromGlyphCache(font, renderer, image, header.height, header.ascent, header.descent, FC_MakeColor(255, 255, 255, 255))) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to upload font atlas\n");
+		SDL_FreeSurface(image);
+		FC_FreeFont(font);
+		return NULL;
+	}
+	SDL_FreeSurface(image);
+
+	for (int i = 0; i < FONT_ATLAS_GLYPHS; ++i) {
+		SDL_Rect rect = header.glyphs[i];
+		if (rect.w > 0 && rect.h > 0) {
+			FC_SetGlyphData(font, FONT_ATLAS_FIRST + i, FC_MakeGlyphData(0, rect.x, rect.y, rect.w, rect.h));
+		}
+	}
+
+	return font;
+}
+
+FC_Font* Font_load(SDL_Renderer* renderer) {
+	if (RESOURCE_FONT_ATLAS_LENGTH > 0) {
+		SDL_RWops* rw = SDL_RWFromConstMem(RESOURCE_FONT_ATLAS, RESOURCE_FONT_ATLAS_LENGTH);
+		FC_Font* font = rw != NULL ? Font_load_atlas(renderer, rw) : NULL;
+		if (rw != NULL) {
+			SDL_RWclose(rw);
+		}
+		if (font != NULL) {
+			return font;
+		}
+	}
+
+	// Rasterizing takes most of startup and whatever it doesn't load up front stalls the frame that first draws it
+	SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "No usable font atlas in this build, rasterizing the font\n");
+	SDL_RWops* rw = SDL_RWFromConstMem(RESOURCE_FONT, RESOURCE_FONT_LENGTH);
+	FC_Font* font = FC_CreateFont();
+	if (rw == NULL || !FC_LoadFont_RW(font, renderer, rw, 1, FONT_SIZE, FC_MakeColor(255, 255, 255, 255), TTF_STYLE_NORMAL)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load the embedded font\n");
+		FC_FreeFont(font);
+		return NULL;
+	}
+
+	return font;
+}
@@ -0,0 +1,93 @@
+#include "../include/gradient.h"
+
+static const float COLOR_ANIM_FACTOR = 14.0f;
+
+static Gradient gradients[GRADIENTS_COUNT];
+static int gradients_built = 0;
+
+// Replays the per-tick r/g/b decrements cells used to apply to themselves, so age N maps to the exact color
+// a cell had N ticks after it flashed white
+static void build_classic(Gradient* gradient) {
+	Uint8 r = 255, g = 255, b = 255;
+	for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+		gradient->alive[age] = (SDL_Color){r, g, b, 255};
+
+		float dr = r > COLOR_ANIM_FACTOR / 8 ? COLOR_ANIM_FACTOR / 8 : 0.0f;
+		float dg = g > COLOR_ANIM_FACTOR / 16 ? COLOR_ANIM_FACTOR / 16 : 0.0f;
+		float db = b > 150 + COLOR_ANIM_FACTOR / 32 ? COLOR_ANIM_FACTOR / 32 : 0.0f;
+		r -= dr;
+		g -= dg;
+		b -= db;
+	}
+
+	r = g = b = 255;
+	for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+		gradient->dead[age] = (SDL_Color){r, g, b, 255};
+
+		float dr = r > COLOR_ANIM_FACTOR / 4 ? COLOR_ANIM_FACTOR / 4 : 0.0f;
+		float dg = g > COLOR_ANIM_FACTOR / 2 ? COLOR_ANIM_FACTOR / 2 : 0.0f;
+		float db = b > COLOR_ANIM_FACTOR ? COLOR_ANIM_FACTOR : 0.0f;
+		r -= dr;
+		g -= dg;
+		b -= db;
+	}
+
+	// Cells that have never changed were drawn pure black
+	gradient->dead[CELL_AGE_MAX] = (SDL_Color){0, 0, 0, 255};
+}
+
+static void build_mono(Gradient* gradient) {
+	for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+		gradient->alive[age] = (SDL_Color){255, 255, 255, 255};
+		gradient->dead[age] = (SDL_Color){0, 0, 0, 255};
+	}
+}
+
+// Linear interpolation between two colors, t in <0, 1>
+static SDL_Color lerp_color(SDL_Color a, SDL_Color b, float t) {
+	return (SDL_Color){
+		a.r + (b.r - a.r) * t,
+		a.g + (b.g - a.g) * t,
+		a.b + (b.b - a.b) * t,
+		255
+	};
+}
+
+static void build_heat(Gradient* gradient) {
+	const SDL_Color white = {255, 255, 255, 255}, yellow = {255, 220, 40, 255}, red = {200, 30, 10, 255};
+	const SDL_Color ember = {90, 10, 0, 255}, black = {0, 0, 0, 255};
+	const int FADE = 64;
+
+	for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+		if (age < FADE / 4) {
+			gradient->alive[age] = lerp_color(white, yellow, age / (FADE / 4.0f));
+		}
+		else if (age < FADE) {
+			gradient->alive[age] = lerp_color(yellow, red, (age - FADE / 4) / (FADE * 3 / 4.0f));
+		}
+		else {
+			gradient->alive[age] = red;
+		}
+
+		gradient->dead[age] = age < FADE / 2 ? lerp_color(ember, black, age / (FADE / 2.0f)) : black;
+	}
+}
+
+const Gradient* Gradient_get(enum Gradients index) {
+	if (!gradients_built) {
+		gradients[GRADIENT_CLASSIC].name = "Classic";
+		build_classic(&gradients[GRADIENT_CLASSIC]);
+		gradients[GRADIENT_MONO].name = "Mono";
+		build_mono(&gradients[GRADIENT_MONO]);
+		gradients[GRADIENT_HEAT].name = "Heat";
+		build_heat(&gradients[GRADIENT_HEAT]);
+
+		gradients_built = 1;
+	}
+
+	if (index < 0 || index >= GRADIENTS_COUNT) {
+		index = GRADIENT_CLASSIC;
+	}
+
+	return &gradients[index];
+}
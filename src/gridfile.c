@@ -0,0 +1,285 @@
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+#include "../include/gridfile.h"
+
+static const char GRID_FILE_MAGIC[8] = "GOLGRID";
+static const Uint32 GRID_FILE_VERSION = 1;
+static const Uint32 GRID_FILE_BYTE_ORDER = 0x01020304;  // reads differently on a host of the other endianness
+
+// Written as is, every field is naturally aligned so there is no padding
+typedef struct GridFileHeaderStruct {
+	char magic[8];
+	Uint32 version;
+	Uint32 byte_order;
+	Uint64 width, height;
+	Uint64 words_per_row;
+	Uint64 generation;
+	Uint32 tile_width, tile_height;
+	Uint64 activity_offset;  // one byte per tile, non-zero if it has to be stepped
+	Uint64 cells_offset;
+	char rule[32];
+} GridFileHeader;
+
+static inline Uint64 page_align(Uint64 offset) {
+	return (offset + GRID_FILE_PAGE_SIZE - 1) / GRID_FILE_PAGE_SIZE * GRID_FILE_PAGE_SIZE;
+}
+
+// Pads file with zeros up to offset
+static int pad_to(FILE* file, Uint64 position, Uint64 offset) {
+	static const char zeros[GRID_FILE_PAGE_SIZE];
+
+	while (position < offset) {
+		size_t count = SDL_min(offset - position, sizeof(zeros));
+		if (fwrite(zeros, 1, count, file) != count) {
+			return -1;
+		}
+		position += count;
+	}
+
+	return 0;
+}
+
+int GridFile_save(const CellsGrid* cells_grid, const char* path) {
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	size_t words = cells_grid->words_per_row * cells_grid->height;
+
+	GridFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GRID_FILE_MAGIC, sizeof(header.magic));
+	header.version = GRID_FILE_VERSION;
+	header.byte_order = GRID_FILE_BYTE_ORDER;
+	header.width = cells_grid->width;
+	header.height = cells_grid->height;
+	header.words_per_row = cells_grid->words_per_row;
+	header.generation = cells_grid->generation;
+	header.tile_width = CELLS_WORD_BITS;
+	header.tile_height = CELLS_TILE_ROWS;
+	header.activity_offset = GRID_FILE_PAGE_SIZE;
+	header.cells_offset = page_align(header.activity_offset + tiles);
+	Rule_format(cells_grid->rule, header.rule, sizeof(header.rule));
+
+	// Mapped grids keep reading the old file until they're deleted, so it's replaced rather than overwritten
+	char temp_path[1024];
+	if ((size_t)snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= sizeof(temp_path)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Grid file path '%s' is too long\n", path);
+		return -1;
+	}
+
+	FILE* file = fopen(temp_path, "wb");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' for writing\n", temp_path);
+		return -1;
+	}
+
+	// Untouched tiles have nothing pending, so pending changes and activity are saved together. Snapshots don't
+	// track activity, every tile of theirs is saved as active and settles down after a step
+	int failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+				 pad_to(file, sizeof(header), header.activity_offset) != 0;
+	int tracks_activity = cells_grid->tile_active != NULL && cells_grid->tile_changed != NULL;
+	for (size_t i = 0; !failed && i < tiles; ++i) {
+		failed = fputc(!tracks_activity || cells_grid->tile_active[i] || cells_grid->tile_changed[i], file) == EOF;
+	}
+	failed = failed || pad_to(file, header.activity_offset + tiles, header.cells_offset) != 0;
+
+	// Rows go out straight from memory, in chunks so the OS can start writing back early
+	const size_t CHUNK_WORDS = (size_t)1 << 20;
+	for (size_t i = 0; !failed && i < words; i += CHUNK_WORDS) {
+		size_t count = SDL_min(CHUNK_WORDS, words - i);
+		failed = fwrite(cells_grid->cells + i, sizeof(CellsWord), count, file) != count;
+	}
+
+	failed = fclose(file) != 0 || failed;
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write grid file '%s'\n", temp_path);
+		remove(temp_path);
+		return -1;
+	}
+
+#ifdef _WIN32
+	// rename() doesn't replace existing files on Windows
+	remove(path);
+#endif
+	if (rename(temp_path, path) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to replace grid file '%s'\n", path);
+		remove(temp_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Maps the whole file copy-on-write, returns NULL on failure
+static void* map_file(const char* path, size_t* size) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return NULL;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == NULL) {
+		return NULL;
+	}
+
+	*size = file_size.QuadPart;
+	return view;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void* view = mmap(NULL, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		return NULL;
+	}
+
+	*size = file_stat.st_size;
+	return view;
+#endif
+}
+
+void GridFile_unmap(void* mapping, size_t size) {
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(mapping);
+#else
+	munmap(mapping, size);
+#endif
+}
+
+void* GridFile_map_again(const CellsGrid* cells_grid, size_t* size) {
+	if (cells_grid->mapping == NULL || cells_grid->mapping_path == NULL) {
+		return NULL;
+	}
+
+	Uint8* mapping = map_file(cells_grid->mapping_path, size);
+	if (mapping == NULL) {
+		return NULL;
+	}
+
+	// Saving renames a new file over the old one, its header or activity would differ
+	size_t cells_offset = (const Uint8*)cells_grid->cells - (const Uint8*)cells_grid->mapping;
+	if (*size != cells_grid->mapping_size || memcmp(mapping, cells_grid->mapping, cells_offset) != 0) {
+		GridFile_unmap(mapping, *size);
+		return NULL;
+	}
+
+	return mapping;
+}
+
+int GridFile_peek(const char* path, size_t* width, size_t* height) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open grid file '%s'\n", path);
+		return -1;
+	}
+
+	GridFileHeader header;
+	int result = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, GRID_FILE_MAGIC, sizeof(header.magic)) == 0 ? 0 : -1;
+	fclose(file);
+	if (result != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' is not a grid file\n", path);
+		return -1;
+	}
+
+	*width = header.width;
+	*height = header.height;
+	return 0;
+}
+
+CellsGrid* GridFile_map(const char* path, unsigned int cell_size) {
+	size_t size;
+	Uint8* mapping = map_file(path, &size);
+	if (mapping == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map grid file '%s'\n", path);
+		return NULL;
+	}
+
+	GridFileHeader header;
+	if (size < sizeof(header)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' is too short to be a grid file\n", path);
+		GridFile_unmap(mapping, size);
+		return NULL;
+	}
+	memcpy(&header, mapping, sizeof(header));
+
+	Rule rule;
+	header.rule[sizeof(header.rule) - 1] = '\0';
+	const char* error = NULL;
+	if (memcmp(header.magic, GRID_FILE_MAGIC, sizeof(header.magic)) != 0) {
+		error = "not a grid file";
+	}
+	else if (header.version != GRID_FILE_VERSION) {
+		error = "unsupported version";
+	}
+	else if (header.byte_order != GRID_FILE_BYTE_ORDER) {
+		error = "saved on a machine of different byte order";
+	}
+	else if (header.width == 0 || header.height == 0 || header.width > SIZE_MAX / header.height ||
+			 header.words_per_row != (header.width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS) {
+		error = "invalid dimensions";
+	}
+	else if (header.cells_offset % GRID_FILE_PAGE_SIZE != 0 ||
+			 header.cells_offset > size || (size - header.cells_offset) / sizeof(CellsWord) / header.height < header.words_per_row) {
+		error = "truncated";
+	}
+	else if (Rule_parse(header.rule, &rule) != 0) {
+		error = "invalid rule";
+	}
+
+	if (error != NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load grid file '%s': %s\n", path, error);
+		GridFile_unmap(mapping, size);
+		return NULL;
+	}
+
+	CellsGrid* cells_grid = CellsGrid_create_mapped(header.width, header.height, cell_size, (CellsWord*)(mapping + header.cells_offset), mapping, size);
+	if (cells_grid == NULL) {
+		GridFile_unmap(mapping, size);
+		return NULL;
+	}
+	cells_grid->rule = rule;
+	cells_grid->generation = header.generation;
+
+	// Snapshots copy the cells instead of mapping the file again without it
+	cells_grid->mapping_path = malloc(strlen(path) + 1);
+	if (cells_grid->mapping_path != NULL) {
+		memcpy(cells_grid->mapping_path, path, strlen(path) + 1);
+	}
+
+	// Activity map is only usable if it was saved with the same tiling, otherwise everything gets stepped once
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	if (header.tile_width == CELLS_WORD_BITS && header.tile_height == CELLS_TILE_ROWS &&
+		header.activity_offset >= sizeof(header) && header.activity_offset + tiles <= header.cells_offset) {
+		memcpy(cells_grid->tile_active, mapping + header.activity_offset, tiles);
+	}
+
+	return cells_grid;
+}
@@ -0,0 +1,430 @@
+#include "../include/history.h"
+#include "../include/runs.h"
+
+// Keyframes are taken once the deltas since the last one outweigh it, but not closer than this
+static const size_t HISTORY_KEYFRAME_SPACING_MIN = 16;
+
+// Steps get an entry every this many generations, rewinding into the ones between steps them again from the
+// entry before. Keeps recording a few percent of stepping even when every tile changes every generation
+static const Uint64 HISTORY_STEP_STRIDE = 16;
+
+// Most a tile can take in a delta: index gap, row mask and every row
+static const size_t HISTORY_TILE_BOUND = 10 + sizeof(Uint64) * (CELLS_TILE_ROWS + 1);
+
+static const size_t HISTORY_NO_ROOM = (size_t)-1;
+
+static inline size_t grid_words(const CellsGrid* cells_grid) {
+	return cells_grid->words_per_row * cells_grid->height;
+}
+
+static inline HistoryEntry* entry_at(History* history, size_t index) {
+	return &history->entries[(history->first + index) % history->capacity];
+}
+
+// Offset of the oldest data in the arena, returns 0 if there is none
+static int find_tail(History* history, size_t* tail) {
+	for (size_t i = 0; i < history->count; ++i) {
+		const HistoryEntry* entry = entry_at(history, i);
+		if (entry->delta_size != 0 || entry->keyframe_size != 0) {
+			*tail = entry->delta_size != 0 ? entry->delta_offset : entry->keyframe_offset;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Finds size contiguous bytes at the head of the arena, dropping the oldest entries but the newest keep ones to
+// make room. Returns their offset or HISTORY_NO_ROOM, the head is moved by the caller once they're written
+static size_t reserve(History* history, size_t size, size_t keep) {
+	if (size > history->arena_size) {
+		return HISTORY_NO_ROOM;
+	}
+
+	for (;;) {
+		size_t tail;
+		if (!find_tail(history, &tail)) {
+			history->head = 0;
+			return 0;
+		}
+
+		// Data runs from the tail to the head, wrapped around the end if the head is behind
+		if (history->head > tail) {
+			if (history->arena_size - history->head >= size) {
+				return history->head;
+			}
+			if (tail >= size) {
+				return 0;
+			}
+		}
+		else if (tail - history->head >= size) {
+			return history->head;
+		}
+
+		if (history->count <= keep) {
+			return HISTORY_NO_ROOM;
+		}
+		history->first = (history->first + 1) % history->capacity;
+		--history->count;
+	}
+}
+
+static int push_entry(History* history, const HistoryEntry* entry) {
+	if (history->count == history->capacity) {
+		size_t capacity = history->capacity * 2;
+		HistoryEntry* entries = malloc(sizeof(HistoryEntry) * capacity);
+		if (entries == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for history entries\n");
+			return -1;
+		}
+
+		for (size_t i = 0; i < history->count; ++i) {
+			entries[i] = *entry_at(history, i);
+		}
+		free(history->entries);
+		history->entries = entries;
+		history->capacity = capacity;
+		history->first = 0;
+	}
+
+	*entry_at(history, history->count++) = *entry;
+	return 0;
+}
+
+// Codes the whole shadow into the newest entry, raw if that's not smaller. Skipped if it doesn't fit
+static void add_keyframe(History* history, size_t words) {
+	size_t raw_size = words * sizeof(CellsWord);
+	size_t offset = reserve(history, raw_size, 1);
+	if (offset == HISTORY_NO_ROOM) {
+		return;
+	}
+
+	size_t length = Runs_encode_words(history->shadow, words, history->arena + offset, raw_size - 1);
+	if (length == 0) {
+		memcpy(history->arena + offset, history->shadow, raw_size);
+		length = raw_size;
+	}
+
+	HistoryEntry* entry = entry_at(history, history->count - 1);
+	entry->keyframe_offset = offset;
+	entry->keyframe_size = length;
+	history->head = offset + length;
+
+	history->last_keyframe_size = length;
+	history->entries_since_keyframe = 0;
+	history->deltas_since_keyframe = 0;
+	history->words_since_keyframe = 0;
+}
+
+static int decode_keyframe(History* history, const HistoryEntry* entry, size_t words) {
+	const Uint8* keyframe = history->arena + entry->keyframe_offset;
+	if (entry->keyframe_size == words * sizeof(CellsWord)) {
+		memcpy(history->shadow, keyframe, entry->keyframe_size);
+		return 0;
+	}
+
+	memset(history->shadow, 0, words * sizeof(CellsWord));
+	const Uint8* end = keyframe + entry->keyframe_size;
+	return Runs_decode_words(keyframe, end, history->shadow, words, 0) == end ? 0 : -1;
+}
+
+// XORs a delta into the shadow, which takes it from an entry's state to the previous one's or back
+static int apply_delta(History* history, const CellsGrid* cells_grid, const HistoryEntry* entry) {
+	const Uint8* in = history->arena + entry->delta_offset;
+	const Uint8* end = in + entry->delta_size;
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	size_t next_tile = 0;
+
+	while (in < end) {
+		Uint64 gap, mask;
+		in = Runs_get_varint(in, end, &gap);
+		if (in == NULL || gap >= tiles - next_tile || (size_t)(end - in) < sizeof(mask)) {
+			return -1;
+		}
+		memcpy(&mask, in, sizeof(mask));
+		in += sizeof(mask);
+
+		size_t tile = next_tile + gap;
+		size_t x = tile % cells_grid->tiles_x, y0 = tile / cells_grid->tiles_x * CELLS_TILE_ROWS;
+		size_t rows = SDL_min((size_t)CELLS_TILE_ROWS, cells_grid->height - y0);
+		if ((rows < CELLS_TILE_ROWS && mask >> rows != 0) || (size_t)(end - in) < sizeof(CellsWord) * __builtin_popcountll(mask)) {
+			return -1;
+		}
+
+		for (; mask != 0; mask &= mask - 1) {
+			CellsWord word;
+			memcpy(&word, in, sizeof(word));
+			in += sizeof(word);
+			history->shadow[(y0 + __builtin_ctzll(mask)) * cells_grid->words_per_row + x] ^= word;
+		}
+
+		next_tile = tile + 1;
+	}
+
+	return 0;
+}
+
+History* History_create(const CellsGrid* cells_grid, size_t budget) {
+	History* history = calloc(1, sizeof(History));
+	if (history == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for history\n");
+		return NULL;
+	}
+
+	size_t words = grid_words(cells_grid);
+	history->capacity = 256;
+	history->entries = malloc(sizeof(HistoryEntry) * history->capacity);
+	history->arena_size = budget;
+	history->arena = malloc(budget);
+	history->shadow = malloc(sizeof(CellsWord) * words);
+	history->run_xors = malloc(sizeof(CellsWord) * cells_grid->tiles_x * CELLS_TILE_ROWS);
+	if (history->entries == NULL || history->arena == NULL || history->shadow == NULL || history->run_xors == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for history\n");
+		History_delete(history);
+		return NULL;
+	}
+	memcpy(history->shadow, cells_grid->cells, sizeof(CellsWord) * words);
+	history->modification = cells_grid->modification;
+
+	// First entry has nothing to be a delta against
+	HistoryEntry entry = {cells_grid->generation, 0, 0, 0, 0};
+	push_entry(history, &entry);
+	add_keyframe(history, words);
+
+	return history;
+}
+
+void History_delete(History* history) {
+	free(history->entries);
+	free(history->arena);
+	free(history->shadow);
+	free(history->run_xors);
+	free(history);
+}
+
+int History_record(History* history, const CellsGrid* cells_grid) {
+	if (cells_grid->modification == history->modification) {
+		return 0;
+	}
+
+	// Only tile rows stamped since are looked at, so boards with little going on cost little however big
+	size_t changed_tiles = 0;
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		if (cells_grid->tile_row_modification[tile_y] <= history->modification) {
+			continue;
+		}
+		const Uint64* stamps = cells_grid->tile_modification + tile_y * cells_grid->tiles_x;
+		for (size_t tile_x = 0; tile_x < cells_grid->tiles_x; ++tile_x) {
+			changed_tiles += stamps[tile_x] > history->modification;
+		}
+	}
+
+	// A delta that could outgrow the whole arena breaks the chain, so the history starts over from here
+	size_t offset = changed_tiles != 0 ? reserve(history, changed_tiles * HISTORY_TILE_BOUND, 0) : history->head;
+	Uint8* out = NULL;
+	if (offset == HISTORY_NO_ROOM) {
+		history->count = 0;
+		offset = 0;
+	}
+	else {
+		out = history->arena + offset;
+	}
+
+	// XOR runs of changed tiles in a tile row against the shadow a row at a time, bringing it up to date on the
+	// way, then write them out tile by tile
+	const Uint8* begin = out;
+	size_t next_tile = 0;
+	size_t walked = 0;
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y && changed_tiles != 0; ++tile_y) {
+		if (cells_grid->tile_row_modification[tile_y] <= history->modification) {
+			continue;
+		}
+
+		const Uint64* stamps = cells_grid->tile_modification + tile_y * cells_grid->tiles_x;
+		size_t y0 = tile_y * CELLS_TILE_ROWS;
+		size_t rows = SDL_min((size_t)CELLS_TILE_ROWS, cells_grid->height - y0);
+
+		for (size_t run_begin = 0; run_begin < cells_grid->tiles_x; ++run_begin) {
+			if (stamps[run_begin] <= history->modification) {
+				continue;
+			}
+			size_t run_end = run_begin + 1;
+			while (run_end < cells_grid->tiles_x && stamps[run_end] > history->modification) {
+				++run_end;
+			}
+
+			size_t run = run_end - run_begin;
+			walked += run * rows;
+			for (size_t r = 0; r < rows; ++r) {
+				CellsWord* shadow = history->shadow + (y0 + r) * cells_grid->words_per_row + run_begin;
+				const CellsWord* cells = CellsGrid_row(cells_grid, y0 + r) + run_begin;
+				CellsWord* xors = history->run_xors + r * run;
+				for (size_t i = 0; i < run; ++i) {
+					xors[i] = shadow[i] ^ cells[i];
+				}
+				memcpy(shadow, cells, sizeof(CellsWord) * run);
+			}
+
+			for (size_t i = 0; out != NULL && i < run; ++i) {
+				// Branch-free: every word is written, but the end only moves past the ones that changed
+				size_t tile = tile_y * cells_grid->tiles_x + run_begin + i;
+				Uint8* tile_begin = out;
+				out += Runs_put_varint(out, tile - next_tile);
+				Uint8* mask_out = out;
+				out += sizeof(Uint64);
+				Uint64 mask = 0;
+				for (size_t r = 0; r < rows; ++r) {
+					CellsWord word = history->run_xors[r * run + i];
+					memcpy(out, &word, sizeof(word));
+					out += (word != 0) * sizeof(word);
+					mask |= (Uint64)(word != 0) << r;
+				}
+
+				// Edited tiles get stamped again by the step that follows, even if it leaves them as they were
+				if (mask == 0) {
+					out = tile_begin;
+					continue;
+				}
+
+				memcpy(mask_out, &mask, sizeof(mask));
+				next_tile = tile + 1;
+			}
+
+			run_begin = run_end;
+		}
+	}
+	history->modification = cells_grid->modification;
+
+	// Edits that didn't change anything, like holding the mouse over a cell, make no entry
+	size_t length = out - begin;
+	if (length == 0 && history->count > 0 && cells_grid->generation == entry_at(history, history->count - 1)->generation) {
+		return 0;
+	}
+	if (length != 0) {
+		history->head = offset + length;
+	}
+
+	HistoryEntry entry = {cells_grid->generation, offset, length, 0, 0};
+	if (push_entry(history, &entry) != 0) {
+		return -1;
+	}
+
+	// Keyframe once rebuilding from the previous one would cost more than it, and once the deltas walked as many
+	// words as it reads, so on boards with little going on it doesn't cost more than they did
+	++history->entries_since_keyframe;
+	history->deltas_since_keyframe += length;
+	history->words_since_keyframe += walked;
+	if (history->count == 1 ||
+		(history->entries_since_keyframe >= HISTORY_KEYFRAME_SPACING_MIN && history->deltas_since_keyframe > history->last_keyframe_size &&
+		 history->words_since_keyframe >= grid_words(cells_grid))) {
+		add_keyframe(history, grid_words(cells_grid));
+	}
+
+	return 0;
+}
+
+int History_record_step(History* history, const CellsGrid* cells_grid) {
+	if (history->count > 0 && cells_grid->generation - entry_at(history, history->count - 1)->generation < HISTORY_STEP_STRIDE) {
+		return 0;
+	}
+
+	return History_record(history, cells_grid);
+}
+
+size_t History_rewind(History* history, CellsGrid* cells_grid, size_t steps) {
+	// Entries further apart than a generation are that many steps apart, the target is the newest entry at or
+	// before the state steps back, stepped forward by the generations left
+	size_t target = history->count - 1;
+	size_t rewound = 0;
+	Uint64 forward = 0;
+	while (rewound < steps && target > 0) {
+		Uint64 newer = entry_at(history, target)->generation, older = entry_at(history, target - 1)->generation;
+		Uint64 gap = newer > older ? newer - older : 1;
+		--target;
+		if (gap > steps - rewound) {
+			forward = gap - (steps - rewound);
+			rewound = steps;
+			break;
+		}
+		rewound += gap;
+	}
+	if (rewound == 0) {
+		return 0;
+	}
+
+	// Either undo deltas from the newest entry or redo them from the closest keyframe, whichever reads less
+	size_t backward_cost = 0;
+	for (size_t i = target + 1; i < history->count; ++i) {
+		backward_cost += entry_at(history, i)->delta_size;
+	}
+
+	size_t keyframe = target + 1;
+	size_t forward_cost = 0;
+	for (size_t i = target + 1; i-- > 0;) {
+		const HistoryEntry* entry = entry_at(history, i);
+		if (entry->keyframe_size != 0) {
+			keyframe = i;
+			forward_cost += entry->keyframe_size;
+			break;
+		}
+		forward_cost += entry->delta_size;
+	}
+
+	int failed = 0;
+	if (keyframe <= target && forward_cost < backward_cost) {
+		failed = decode_keyframe(history, entry_at(history, keyframe), grid_words(cells_grid)) != 0;
+		for (size_t i = keyframe + 1; !failed && i <= target; ++i) {
+			failed = apply_delta(history, cells_grid, entry_at(history, i)) != 0;
+		}
+	}
+	else {
+		for (size_t i = history->count - 1; !failed && i > target; --i) {
+			failed = apply_delta(history, cells_grid, entry_at(history, i)) != 0;
+		}
+	}
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "History is corrupted, can't rewind\n");
+		return 0;
+	}
+
+	// Entries after the target are gone, the next step starts a new timeline after the last data left
+	history->count = target + 1;
+	history->head = 0;
+	for (size_t i = history->count; i-- > 0;) {
+		const HistoryEntry* entry = entry_at(history, i);
+		if (entry->keyframe_size != 0 || entry->delta_size != 0) {
+			history->head = entry->keyframe_size != 0 ? entry->keyframe_offset + entry->keyframe_size : entry->delta_offset + entry->delta_size;
+			break;
+		}
+	}
+
+	history->entries_since_keyframe = 0;
+	history->deltas_since_keyframe = 0;
+	history->words_since_keyframe = 0;
+	history->last_keyframe_size = 0;
+	for (size_t i = history->count; i-- > 0;) {
+		const HistoryEntry* entry = entry_at(history, i);
+		if (entry->keyframe_size != 0) {
+			history->last_keyframe_size = entry->keyframe_size;
+			break;
+		}
+		++history->entries_since_keyframe;
+		history->deltas_since_keyframe += entry->delta_size;
+	}
+
+	// Cells are restored as if edited by hand, so the ages start over and every tile gets stepped
+	memcpy(cells_grid->cells, history->shadow, sizeof(CellsWord) * grid_words(cells_grid));
+	CellsGrid_set_generation(cells_grid, entry_at(history, target)->generation);
+	CellsGrid_touch(cells_grid, 0, 0, cells_grid->width, cells_grid->height);
+	history->modification = cells_grid->modification;
+
+	// Generations that weren't recorded are stepped again, the state they end at becomes the newest entry
+	if (forward != 0) {
+		for (Uint64 i = 0; i < forward; ++i) {
+			CellsGrid_step(cells_grid);
+		}
+		History_record(history, cells_grid);
+	}
+
+	return rewound;
+}
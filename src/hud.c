@@ -0,0 +1,113 @@
+#include "../include/hud.h"
+
+void Hud_init(Hud* hud, FC_Font* font, float x, float y) {
+	memset(hud, 0, sizeof(Hud));
+	hud->font = font;
+	hud->x = x;
+	hud->y = y;
+}
+
+// Places a quad per glyph the same way FC_Draw would, advancing by the glyph's width and the letter spacing
+static void layout_line(Hud* hud, int line) {
+	SDL_Color color = FC_GetDefaultColor(hud->font);
+	float x = hud->x, y = hud->y + line * (FC_GetLineHeight(hud->font) + FC_GetLineSpacing(hud->font));
+	int count = 0;
+
+	for (const char* c = hud->lines[line]; *c != '\0'; ++c) {
+		FC_GlyphData glyph;
+		Uint32 codepoint = FC_GetCodepointFromUTF8(&c, 1);
+		if (!FC_GetGlyphData(hud->font, &glyph, codepoint)) {
+			codepoint = ' ';
+			if (!FC_GetGlyphData(hud->font, &glyph, codepoint)) {
+				continue;
+			}
+		}
+
+		int texture_width, texture_height;
+		if (codepoint != ' ' && glyph.cache_level < HUD_MAX_CACHE_LEVELS &&
+			SDL_QueryTexture(FC_GetGlyphCacheLevel(hud->font, glyph.cache_level), NULL, NULL, &texture_width, &texture_height) == 0) {
+			float u0 = (float)glyph.rect.x / texture_width, u1 = (float)(glyph.rect.x + glyph.rect.w) / texture_width;
+			float v0 = (float)glyph.rect.y / texture_height, v1 = (float)(glyph.rect.y + glyph.rect.h) / texture_height;
+			SDL_Vertex* quad = hud->vertices[line] + count * 4;
+			quad[0] = (SDL_Vertex){{x, y}, color, {u0, v0}};
+			quad[1] = (SDL_Vertex){{x + glyph.rect.w, y}, color, {u1, v0}};
+			quad[2] = (SDL_Vertex){{x + glyph.rect.w, y + glyph.rect.h}, color, {u1, v1}};
+			quad[3] = (SDL_Vertex){{x, y + glyph.rect.h}, color, {u0, v1}};
+			hud->cache_levels[line][count++] = glyph.cache_level;
+		}
+
+		x += glyph.rect.w + FC_GetSpacing(hud->font);
+	}
+
+	hud->glyph_counts[line] = count;
+	hud->indices_stale = 1;
+}
+
+void Hud_set_line(Hud* hud, int line, const char* format, ...) {
+	if (line < 0 || line >= HUD_MAX_LINES) {
+		return;
+	}
+
+	char text[HUD_LINE_LENGTH];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (line >= hud->line_count) {
+		hud->line_count = line + 1;
+		hud->indices_stale = 1;
+	}
+	if (strcmp(text, hud->lines[line]) == 0) {
+		return;
+	}
+	memcpy(hud->lines[line], text, sizeof(text));
+	layout_line(hud, line);
+}
+
+void Hud_set_line_count(Hud* hud, int line_count) {
+	line_count = SDL_clamp(line_count, 0, HUD_MAX_LINES);
+	if (line_count != hud->line_count) {
+		hud->line_count = line_count;
+		hud->indices_stale = 1;
+	}
+}
+
+// Two triangles a glyph, grouped by the texture they sample
+static void build_indices(Hud* hud) {
+	int count = 0;
+	for (int level = 0; level < HUD_MAX_CACHE_LEVELS; ++level) {
+		int start = count;
+		for (int line = 0; line < hud->line_count; ++line) {
+			for (int glyph = 0; glyph < hud->glyph_counts[line]; ++glyph) {
+				if (hud->cache_levels[line][glyph] != level) {
+					continue;
+				}
+				int first = (line * HUD_LINE_LENGTH + glyph) * 4;
+				int corners[6] = {0, 1, 2, 0, 2, 3};
+				for (int i = 0; i < 6; ++i) {
+					hud->indices[count++] = first + corners[i];
+				}
+			}
+		}
+		hud->index_counts[level] = count - start;
+	}
+
+	hud->indices_stale = 0;
+}
+
+void Hud_draw(Hud* hud, SDL_Renderer* renderer) {
+	if (hud->indices_stale) {
+		build_indices(hud);
+	}
+
+	int start = 0;
+	for (int level = 0; level < HUD_MAX_CACHE_LEVELS; ++level) {
+		if (hud->index_counts[level] > 0 &&
+			SDL_RenderGeometry(renderer, FC_GetGlyphCacheLevel(hud->font, level), hud->vertices[0], HUD_MAX_LINES * HUD_LINE_LENGTH * 4,
+							   hud->indices + start, hud->index_counts[level]) != 0) {
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render HUD: %s\n", SDL_GetError());
+		}
+		start += hud->index_counts[level];
+	}
+}
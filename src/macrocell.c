@@ -0,0 +1,238 @@
+#include "../include/macrocell.h"
+
+static const char* MACROCELL_HEADER = "[M2]";
+
+static int parse_leaf(const char* line, Uint64* cells) {
+	int row = 0, column = 0;
+	*cells = 0;
+
+	for (const char* c = line; *c != '\0' && *c != '\n' && *c != '\r'; ++c) {
+		if (*c == '$') {
+			++row;
+			column = 0;
+			continue;
+		}
+		if ((*c != '.' && *c != '*') || row >= 8 || column >= 8) {
+			return -1;
+		}
+
+		if (*c == '*') {
+			*cells |= (Uint64)1 << (row * 8 + column);
+		}
+		++column;
+	}
+
+	return 0;
+}
+
+QuadTree* Macrocell_load(const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open macrocell '%s'\n", path);
+		return NULL;
+	}
+
+	QuadTree* quadtree = QuadTree_create();
+	if (quadtree == NULL) {
+		fclose(file);
+		return NULL;
+	}
+
+	// Maps 1-based line numbers of nodes to tree indices, 0 is the empty node in both
+	Uint32* file_nodes = malloc(sizeof(Uint32) * 1024);
+	size_t file_count = 1, file_capacity = 1024;
+	Uint32 root_level = QUADTREE_LEAF_LEVEL;
+	int result = file_nodes != NULL ? 0 : -1;
+	if (file_nodes != NULL) {
+		file_nodes[0] = QUADTREE_EMPTY;
+	}
+
+	char line[1024];
+	size_t line_number = 0;
+	while (result == 0 && fgets(line, sizeof(line), file) != NULL) {
+		++line_number;
+		if (line_number == 1) {
+			if (strncmp(line, MACROCELL_HEADER, strlen(MACROCELL_HEADER)) != 0) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Macrocell '%s' doesn't start with '%s'\n", path, MACROCELL_HEADER);
+				result = -1;
+			}
+			continue;
+		}
+
+		if (line[0] == '#') {
+			if (line[1] == 'R' && Rule_parse(line + 2, &quadtree->rule) != 0) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unsupported rule on line %zu of '%s'\n", line_number, path);
+				result = -1;
+			}
+			else if (line[1] == 'G') {
+				quadtree->generation = strtoull(line + 2, NULL, 10);
+			}
+			continue;
+		}
+		if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+			continue;
+		}
+
+		if (file_count == file_capacity) {
+			Uint32* grown = realloc(file_nodes, sizeof(Uint32) * file_capacity * 2);
+			if (grown == NULL) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for macrocell nodes\n");
+				result = -1;
+				break;
+			}
+			file_nodes = grown;
+			file_capacity *= 2;
+		}
+
+		Uint32 index;
+		if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+			Uint64 cells;
+			if (parse_leaf(line, &cells) != 0) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Malformed leaf on line %zu of '%s'\n", line_number, path);
+				result = -1;
+				break;
+			}
+
+			index = QuadTree_leaf(quadtree, cells);
+			root_level = QUADTREE_LEAF_LEVEL;
+		}
+		else {
+			unsigned int level, child[4];
+			if (sscanf(line, "%u %u %u %u %u", &level, &child[0], &child[1], &child[2], &child[3]) != 5
+				|| level <= QUADTREE_LEAF_LEVEL || level > 0xff) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Malformed node on line %zu of '%s'\n", line_number, path);
+				result = -1;
+				break;
+			}
+
+			// Children have to be defined before and be one level below
+			for (int i = 0; i < 4 && result == 0; ++i) {
+				if (child[i] >= file_count) {
+					result = -1;
+					break;
+				}
+				child[i] = file_nodes[child[i]];
+				if (child[i] != QUADTREE_EMPTY && quadtree->nodes[child[i]].level != level - 1) {
+					result = -1;
+				}
+			}
+			if (result != 0) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Bad child reference on line %zu of '%s'\n", line_number, path);
+				break;
+			}
+
+			index = QuadTree_node(quadtree, level, child[0], child[1], child[2], child[3]);
+			root_level = level;
+		}
+
+		if (index == 0xffffffff) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Ran out of memory loading macrocell '%s'\n", path);
+			result = -1;
+			break;
+		}
+		file_nodes[file_count++] = index;
+	}
+
+	if (result == 0 && file_count == 1) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Macrocell '%s' has no nodes\n", path);
+		result = -1;
+	}
+	if (result == 0) {
+		quadtree->root = file_nodes[file_count - 1];
+		quadtree->root_level = root_level;
+	}
+
+	free(file_nodes);
+	fclose(file);
+	if (result != 0) {
+		QuadTree_delete(quadtree);
+		return NULL;
+	}
+
+	return quadtree;
+}
+
+static void write_leaf(FILE* file, Uint64 cells) {
+	char line[8 * 9 + 2];
+	size_t length = 0;
+
+	// Trailing dead cells of a row and trailing empty rows are left out
+	for (int row = 0; row < 8 && (cells >> (row * 8)) != 0; ++row) {
+		unsigned int byte = (cells >> (row * 8)) & 0xff;
+		for (int column = 0; byte >> column != 0; ++column) {
+			line[length++] = (byte >> column & 1) ? '*' : '.';
+		}
+		line[length++] = '$';
+	}
+	if (length == 0) {
+		line[length++] = '$';
+	}
+
+	line[length++] = '\n';
+	fwrite(line, 1, length, file);
+}
+
+// Writes node after its children, file_index holds 1-based line numbers of nodes already written
+static Uint32 write_node(const QuadTree* quadtree, FILE* file, Uint32* file_index, Uint32* file_count, Uint32 index) {
+	if (index == QUADTREE_EMPTY) {
+		return 0;
+	}
+	if (file_index[index] != 0) {
+		return file_index[index];
+	}
+
+	const QuadNode* node = &quadtree->nodes[index];
+	if (node->level == QUADTREE_LEAF_LEVEL) {
+		write_leaf(file, node->leaf);
+	}
+	else {
+		Uint32 child[4];
+		for (int i = 0; i < 4; ++i) {
+			child[i] = write_node(quadtree, file, file_index, file_count, node->child[i]);
+		}
+		fprintf(file, "%u %u %u %u %u\n", node->level, child[0], child[1], child[2], child[3]);
+	}
+
+	file_index[index] = ++*file_count;
+	return file_index[index];
+}
+
+int Macrocell_save(const QuadTree* quadtree, const char* path) {
+	Uint32* file_index = calloc(quadtree->node_count, sizeof(Uint32));
+	if (file_index == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for macrocell writer\n");
+		return -1;
+	}
+
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' for writing\n", path);
+		free(file_index);
+		return -1;
+	}
+
+	char rule[32];
+	Rule_format(quadtree->rule, rule, sizeof(rule));
+	fprintf(file, "%s (game-of-life)\n#R %s\n", MACROCELL_HEADER, rule);
+	if (quadtree->generation != 0) {
+		fprintf(file, "#G %llu\n", (unsigned long long)quadtree->generation);
+	}
+
+	// An empty pattern still needs a root, a blank leaf does
+	Uint32 file_count = 0;
+	if (quadtree->root == QUADTREE_EMPTY) {
+		write_leaf(file, 0);
+	}
+	else {
+		write_node(quadtree, file, file_index, &file_count, quadtree->root);
+	}
+	free(file_index);
+
+	int result = ferror(file) ? -1 : 0;
+	if (fclose(file) != 0 || result != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write macrocell '%s'\n", path);
+		return -1;
+	}
+
+	return 0;
+}
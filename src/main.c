@@ -1,66 +1,246 @@
 #include <time.h>
-#include "../lib/SDL_FontCache.h"
 
 #include "../include/utils.h"
 #include "../include/cells.h"
+#include "../include/config.h"
+#include "../include/gridfile.h"
+#include "../include/rle.h"
+#include "../include/macrocell.h"
+#include "../include/checkpoint.h"
+#include "../include/history.h"
+#include "../include/recording.h"
+#include "../include/video.h"
+#include "../include/writer.h"
+#include "../include/view.h"
+#include "../include/simulation.h"
+#include "../include/pacing.h"
+#include "../include/hud.h"
+#include "../include/profiler.h"
+#include "../include/font.h"
 
-static const Uint32 FONT_SIZE = 26;
 static const Uint32 GUI_GAP = FONT_SIZE * 3;
 
-static const Sint16 CELL_SIZE = 8;
-static const unsigned int CELL_NUMBER_WIDTH = 128;
-static const unsigned int CELL_NUMBER_HEIGHT = 91;
+// Boards bigger than this (in logical pixels) are shown partially
+static const int MAX_VIEW_WIDTH = 1536;
+static const int MAX_VIEW_HEIGHT = 864;
 
-static const int WINDOW_WIDTH = CELL_NUMBER_WIDTH * CELL_SIZE;
-static const int WINDOW_HEIGHT = CELL_NUMBER_HEIGHT * CELL_SIZE + GUI_GAP;
+// Age plane is a byte per cell, so past this it's off regardless of the config
+static const size_t MAX_FADE_CELLS = (size_t)1 << 28;
 
-static const float COLOR_ANIM_FACTOR = 14.0f;
+// Generations skipped by seeking through a recording
+static const Uint64 PLAYER_SEEK_STEP = 1000;
+
+// Longest the loop sleeps while nothing changes, automatic checkpoints are only checked this often then
+static const Uint32 IDLE_TIMEOUT = 250;
+
+// Same while a write holds the latest generation, so the view follows the simulation again soon after
+static const Uint32 HELD_TIMEOUT = 10;
+
+// Frame rate written into Y4M videos
+static const unsigned int VIDEO_FPS = 30;
+
+// Generations per second the arrow keys step through, 0 steps as fast as the board allows
+static const Uint64 SIMULATION_RATES[] = {1, 2, 5, 10, 20, 30, 60, 120, 240, 480, 1000, 2000, 5000, 10000, 0};
+static const int SIMULATION_RATES_COUNT = sizeof(SIMULATION_RATES) / sizeof(SIMULATION_RATES[0]);
+
+// Board to start from: a checkpoint, grid file or recording if one was given, otherwise random cells from the
+// seed, with the pattern on top if there is one. A checkpoint brings its own RNG state. Returns NULL on failure
+static CellsGrid* create_cells_grid(Config* config, int load_checkpoint, Player* player, Uint64 seed, SDL_Window* window) {
+	CellsGrid* cells_grid;
+	if (load_checkpoint) {
+		cells_grid = Checkpoint_load(config->load_path, config->cell_size);
+	}
+	else if (config->load_path[0] != '\0') {
+		cells_grid = GridFile_map(config->load_path, config->cell_size);
+		if (cells_grid != NULL) {
+			CellsGrid_seed(cells_grid, seed);
+		}
+	}
+	else {
+		cells_grid = CellsGrid_create(config->grid_width, config->grid_height, config->cell_size, seed);
+		if (cells_grid != NULL) {
+			cells_grid->rule = config->rule;
+		}
+	}
+
+	if (cells_grid != NULL && player != NULL) {
+		cells_grid->rule = player->rule;
+		if (Player_step(player, cells_grid) != 1) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_WARNING, "Failed to play recording", config->play_path, window);
+		}
+	}
+	else if (cells_grid != NULL && config->pattern_path[0] != '\0') {
+		CellsGrid_clear(cells_grid);
+
+		// Macrocell patterns go through a quadtree and have to fit the board, anything else is read as RLE
+		int pattern_result = -1;
+		if (has_extension(config->pattern_path, ".mc")) {
+			QuadTree* quadtree = Macrocell_load(config->pattern_path);
+			if (quadtree != NULL) {
+				pattern_result = QuadTree_flatten(quadtree, cells_grid, config->pattern_centered, config->pattern_x, config->pattern_y);
+				QuadTree_delete(quadtree);
+			}
+		}
+		else {
+			pattern_result = Rle_load(cells_grid, config->pattern_path, config->pattern_centered, config->pattern_x, config->pattern_y);
+		}
+		if (pattern_result != 0) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_WARNING, "Failed to load pattern", config->pattern_path, window);
+		}
+	}
+
+	return cells_grid;
+}
+
+// Strokes are painted on the simulation thread, a command per mouse event however far it moved
+static void paint(Simulation* simulation, size_t from_x, size_t from_y, size_t x, size_t y, unsigned int radius, int is_alive) {
+	SimulationCommand command = {0};
+	command.type = SIMULATION_PAINT;
+	command.from_x = from_x;
+	command.from_y = from_y;
+	command.x = x;
+	command.y = y;
+	command.radius = radius;
+	command.value = is_alive;
+	Simulation_send(simulation, &command);
+}
+
+// Writes the latest generation in the background, it's held from here on so it isn't refilled (or with a single
+// snapshot, unlocked) while the writer reads it
+static void write_board(Simulation* simulation, BoardWriter* writer, enum BoardWrites type, const CellsGrid* snapshot, const Gradient* gradient, const char* path) {
+	if (BoardWriter_start(writer, type, snapshot, gradient, path) == 0) {
+		Simulation_hold(simulation, 1);
+	}
+}
+
+// Cell under the mouse, returns 0 if there's one
+static int cell_under_mouse(const CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, size_t* cell_x, size_t* cell_y) {
+	int mouse_x, mouse_y;
+	SDL_GetMouseState(&mouse_x, &mouse_y);
+	return CellsView_cell_at(view, cells_grid, viewport, mouse_x / g_scale - viewport->x, mouse_y / g_scale - viewport->y, cell_x, cell_y);
+}
+
+static int set_age_tracking(Config* config, CellsGrid* cells_grid) {
+	if (config->fade && cells_grid->width * cells_grid->height > MAX_FADE_CELLS) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Board too big for fading colors, disabling them\n");
+		config->fade = 0;
+	}
+
+	return CellsGrid_set_age_tracking(cells_grid, config->fade);
+}
+
+// Renders generations into a video file without a window. Frames are rasterised and written on the encoder's
+// threads while the next generations are stepped, so the output only depends on the seed. Returns the exit code
+static int export_video(Config* config, int load_checkpoint, Player* player) {
+	Uint64 seed = config->seeded ? config->seed : (Uint64)time(NULL);
+	CellsGrid* cells_grid = create_cells_grid(config, load_checkpoint, player, seed, NULL);
+	if (cells_grid == NULL) {
+		return 6;
+	}
+	if (set_age_tracking(config, cells_grid) != 0) {
+		CellsGrid_delete(cells_grid);
+		return 7;
+	}
+
+	VideoEncoder* encoder = VideoEncoder_create(cells_grid, Gradient_get(GRADIENT_CLASSIC), config->cell_size, VIDEO_FPS, config->video_path);
+	if (encoder == NULL) {
+		CellsGrid_delete(cells_grid);
+		return 11;
+	}
+
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	unsigned int frames = 0;
+	int result = 0, playing = 1;
+	while (frames < config->video_frames && playing && result == 0) {
+		result = VideoEncoder_add_frame(encoder, cells_grid);
+		++frames;
+
+		// A recording ends the video where it ends
+		for (unsigned int i = 0; i < config->video_every && playing; ++i) {
+			if (player != NULL) {
+				playing = Player_step(player, cells_grid) == 1;
+			}
+			else {
+				CellsGrid_step(cells_grid);
+			}
+		}
+	}
+	if (VideoEncoder_finish(encoder) != 0) {
+		result = -1;
+	}
+
+	if (result == 0) {
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Rendered %u frames to '%s' in %.1f s\n", frames, config->video_path,
+					(SDL_GetPerformanceCounter() - start_time) / (double)SDL_GetPerformanceFrequency());
+	}
+	CellsGrid_delete(cells_grid);
+	return result == 0 ? 0 : 11;
+}
 
 int main(int argc, char* argv[]) {
+	Uint64 startup_start = SDL_GetPerformanceCounter();
+
+	Config config;
+	Config_init(&config);
+
+	int args_result = Config_parse_args(&config, argc, argv);
+	if (args_result != 0) {
+		return args_result > 0 ? 0 : 8;
+	}
+	if (config.verbose) {
+		SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_VERBOSE);
+	}
+
+	// Board size of a saved grid or checkpoint comes from its header
+	int load_checkpoint = has_extension(config.load_path, ".ckpt");
+	if (config.load_path[0] != '\0') {
+		int peek_result = load_checkpoint ? Checkpoint_peek(config.load_path, &config.grid_width, &config.grid_height)
+										  : GridFile_peek(config.load_path, &config.grid_width, &config.grid_height);
+		if (peek_result != 0) {
+			return 9;
+		}
+	}
+
+	// So is the size of a recording played back
+	Player* player = NULL;
+	if (config.play_path[0] != '\0') {
+		player = Player_open(config.play_path);
+		if (player == NULL) {
+			return 10;
+		}
+		config.grid_width = player->width;
+		config.grid_height = player->height;
+	}
+
+	if (config.video_path[0] != '\0') {
+		int video_result = export_video(&config, load_checkpoint, player);
+		if (player != NULL) {
+			Player_delete(player);
+		}
+		return video_result;
+	}
+
+	const int WINDOW_WIDTH = SDL_min((size_t)MAX_VIEW_WIDTH, config.grid_width * config.cell_size);
+	const int WINDOW_HEIGHT = SDL_min((size_t)MAX_VIEW_HEIGHT, config.grid_height * config.cell_size) + GUI_GAP;
+
 	SDL_Window* window = NULL;
 	SDL_Renderer* renderer = NULL;
-	FPSmanager fpsManager;
+	int refresh_rate, vsync;
 
-	if (init_SDL(&window, &renderer, &fpsManager, WINDOW_WIDTH, WINDOW_HEIGHT) != 0) {
+	if (init_SDL(&window, &renderer, &refresh_rate, &vsync, WINDOW_WIDTH, WINDOW_HEIGHT) != 0) {
 		return 1;
 	}
 
-	// Font setup
-	FC_Font* font = FC_CreateFont();
-	const char* font_path = "res/fonts/Minecraft-Regular.otf";
-	if (!FC_LoadFont(font, renderer, font_path, FONT_SIZE, FC_MakeColor(255, 255, 255, 255), TTF_STYLE_NORMAL)) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load font '%s'\n", font_path);
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Failed to load font", font_path, window);
+	// Font setup, glyphs come baked into the executable so nothing is read or rasterized
+	Uint64 font_start = SDL_GetPerformanceCounter();
+	FC_Font* font = Font_load(renderer);
+	if (font == NULL) {
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Failed to load font", "Embedded font is unusable", window);
 
-		FC_FreeFont(font);
 		close_SDL(window, renderer);
 		return 2;
 	}
-	
-  // Load mesh texture
-  const char* mesh_bmp_path = "res/textures/aux_grid.bmp";
-  SDL_Surface* mesh_bmp = SDL_LoadBMP(mesh_bmp_path);
-  if (mesh_bmp == NULL) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load texture '%s': %s\n", mesh_bmp_path, SDL_GetError());
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Failed to load texture", mesh_bmp_path, window);
-
-		FC_FreeFont(font);
-		close_SDL(window, renderer);
-		return 3;
-  }
-
-  // Mesh texture setup
-  SDL_Texture* mesh_texture = SDL_CreateTextureFromSurface(renderer, mesh_bmp);
-  SDL_FreeSurface(mesh_bmp);
-  if (mesh_texture == NULL) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create mesh texture: %s\n", SDL_GetError());
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Failed to create mesh texture", SDL_GetError(), window);
-
-		FC_FreeFont(font);
-		close_SDL(window, renderer);
-		return 4;
-  }
-  SDL_SetTextureScaleMode(mesh_texture, SDL_ScaleModeBest);
+	Uint64 font_time = SDL_GetPerformanceCounter() - font_start;
 
 	// Initialize RNG
 	time_t unix_time = time(NULL);
@@ -69,246 +249,410 @@ int main(int argc, char* argv[]) {
 		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "RNG initialization error", "Failed to retrieve current Unix timestamp", window);
 
 		FC_FreeFont(font);
-    SDL_DestroyTexture(mesh_texture);
 		close_SDL(window, renderer);
 		return 5;
 	}
-	srand(unix_time);
 
 	// Main loop flags
-	int quit = 0, pause = 1, draw_mesh = 0;
+	int quit = 0, draw_mesh = 0, draw_heat = 0, draw_stats = 0;
+
+	// Cell the stroke being painted got to, mouse events come in the renderer's logical coordinates
+	int stroke = 0;
+	size_t stroke_x = 0, stroke_y = 0;
+
+	// Corners of the selected rectangle, the first one is where dragging it started
+	int selecting = 0, selected = 0;
+	size_t selection_x0 = 0, selection_y0 = 0, selection_x1 = 0, selection_y1 = 0;
+
+	enum Gradients gradient_index = GRADIENT_CLASSIC;
 
 	// Events handler
 	SDL_Event e;
 
-	// Stuff for calculating FPS at set interval
-	Uint64 fps_prev_time = 0, fps_current_time;
-	Uint32 fps = 0;
-	Uint32 fps_avg = 0;
-	unsigned int frame_count = 1;
+	// Frames are paced and timed apart from the simulation, which keeps its own rate
+	FramePacer frame_pacer;
+	FramePacer_init(&frame_pacer, refresh_rate, vsync);
 
-	// Stuff for controlling logic calculations speed
-	Uint64 logic_prev_time = 0, logic_current_time;
-	Uint64 logic_delay = 0;  // in miliseconds
+	// Lines are laid out again only when they read differently, usually just the tick
+	Hud hud;
+	Hud_init(&hud, font, 0, 0);
 
-	size_t tick = 0;
+	// Phases are timed every frame, the overlay with them is only shown on request
+	Profiler profiler;
+	Profiler_init(&profiler);
+
+	int rate_index = 0;
+	while (SIMULATION_RATES[rate_index] != SIMULATION_DEFAULT_RATE) {
+		++rate_index;
+	}
 
 	SDL_Rect viewport = {0, GUI_GAP, WINDOW_WIDTH, WINDOW_HEIGHT - GUI_GAP};
 
+	// Saves, exports, screenshots and checkpoints are written from the latest generation in the background, it's
+	// held on to until they're done reading it while the simulation goes on
+	BoardWriter board_writer = {0};
+	Uint64 checkpoint_prev_time = SDL_GetTicks64();
+	int checkpoint_requested = 0;
+
 	// Cells creation
-	CellsGrid* cells_grid = CellsGrid_create(CELL_NUMBER_WIDTH, CELL_NUMBER_HEIGHT, CELL_SIZE);
+	Uint64 seed = config.seeded ? config.seed : (Uint64)unix_time;
+	CellsGrid* cells_grid = create_cells_grid(&config, load_checkpoint, player, seed, window);
 	if (cells_grid == NULL) {
 		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cells initialization error", "Failed to create cells", window);
 
 		FC_FreeFont(font);
-    SDL_DestroyTexture(mesh_texture); 
 		close_SDL(window, renderer);
 		return 6;
 	}
+	if (set_age_tracking(&config, cells_grid) != 0) {
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cells initialization error", "Failed to create cells age plane", window);
+
+		CellsGrid_delete(cells_grid);
+		FC_FreeFont(font);
+		close_SDL(window, renderer);
+		return 7;
+	}
+
+	// Cells are drawn through a texture of the visible ones
+	CellsView* cells_view = CellsView_create(renderer, cells_grid, &viewport);
+	if (cells_view == NULL) {
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Cells initialization error", "Failed to create cells texture", window);
+
+		CellsGrid_delete(cells_grid);
+		FC_FreeFont(font);
+		close_SDL(window, renderer);
+		return 8;
+	}
+
+	// Rewind history, useless unless at least a raw keyframe of the board fits in its budget
+	History* history = NULL;
+	size_t history_budget = config.history_budget << 20;
+	if (history_budget != 0 && sizeof(CellsWord) * cells_grid->words_per_row * cells_grid->height <= history_budget) {
+		history = History_create(cells_grid, history_budget);
+	}
+	else if (history_budget != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Board is bigger than the history budget, rewinding is off\n");
+	}
+
+	// Every generation from here on goes to the recording
+	Recorder* recorder = NULL;
+	if (config.record_path[0] != '\0') {
+		recorder = Recorder_create(cells_grid, config.record_path);
+		if (recorder == NULL) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_WARNING, "Failed to start recording", config.record_path, window);
+		}
+	}
+
+	// Steps happen on their own thread from here on, the grid is only changed through commands and everything
+	// else reads the latest generation it published
+	Simulation* simulation = Simulation_create(cells_grid, player, history, recorder);
+	if (simulation == NULL) {
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Simulation error", "Failed to start simulation", window);
+
+		if (history != NULL) {
+			History_delete(history);
+		}
+		if (recorder != NULL) {
+			Recorder_close(recorder);
+		}
+		if (player != NULL) {
+			Player_delete(player);
+		}
+		CellsView_delete(cells_view);
+		CellsGrid_delete(cells_grid);
+		FC_FreeFont(font);
+		close_SDL(window, renderer);
+		return 12;
+	}
 
-	// Define directions for counting alive neighbours
-	Pair_Sint16 directions[] = {
-		{TOP, LEFT},
-		{TOP, NA},
-		{TOP, RIGHT},
-		{NA, RIGHT},
-		{BOTTOM, RIGHT},
-		{BOTTOM, NA},
-		{BOTTOM, LEFT},
-		{NA, LEFT}
-	};
-	const int DIRECTIONS_SIZE = sizeof(directions) / sizeof(directions[0]);
+	// Nothing on screen changes without input or a new generation, so frames without either are skipped and the
+	// loop sleeps on the event queue until one comes
+	int idle = 0, redraw = 1;
+	Uint64 drawn_generation = 0, drawn_modification = 0;
 
 	// Main loop
 	while (!quit) {
-		Uint32 frame_time = SDL_framerateDelay(&fpsManager);
+		int held = BoardWriter_reading(&board_writer);
+		Simulation_hold(simulation, held);
+		Simulation_release(simulation);  // after skipped frames
+		if (idle) {
+			Simulation_wait(simulation, held ? HELD_TIMEOUT : IDLE_TIMEOUT);
+			FramePacer_idled(&frame_pacer);
+		}
+		FramePacer_wait(&frame_pacer);
+		Profiler_lap(&profiler);  // the wait isn't counted towards any phase
+		const CellsGrid* snapshot = Simulation_latest(simulation);
+		if (snapshot == NULL) {
+			// Only snapshot is being filled, input waits in the queue until it's done
+			idle = 0;
+			SDL_Delay(1);
+			continue;
+		}
+		SimulationCommand command = {0};
 
 		while(SDL_PollEvent(&e) != 0) {
+			redraw |= e.type != simulation->wake_event;
 			switch (e.type) {
 				case SDL_QUIT:
 					quit = 1;
 					break;
+				case SDL_MOUSEWHEEL:  // zooms around the cursor
+					{
+						int mouse_x, mouse_y;
+						SDL_GetMouseState(&mouse_x, &mouse_y);
+						CellsView_zoom(cells_view, snapshot, &viewport, e.wheel.y, mouse_x / g_scale - viewport.x, mouse_y / g_scale - viewport.y);
+					}
+					break;
+				case SDL_MOUSEBUTTONDOWN:  // paints cells (left button - alive, right - dead), with shift selects (left) or deselects (right)
+					if (SDL_GetModState() & KMOD_SHIFT) {
+						size_t cell_x, cell_y;
+						if (e.button.button == SDL_BUTTON_LEFT &&
+							CellsView_cell_at(cells_view, snapshot, &viewport, e.button.x - viewport.x, e.button.y - viewport.y, &cell_x, &cell_y) == 0) {
+							selecting = selected = 1;
+							selection_x0 = selection_x1 = cell_x;
+							selection_y0 = selection_y1 = cell_y;
+						}
+						else if (e.button.button == SDL_BUTTON_RIGHT) {
+							selected = 0;
+						}
+					}
+					else if (e.button.button == SDL_BUTTON_LEFT || e.button.button == SDL_BUTTON_RIGHT) {
+						stroke = CellsView_cell_at(cells_view, snapshot, &viewport, e.button.x - viewport.x, e.button.y - viewport.y, &stroke_x, &stroke_y) == 0;
+						if (stroke) {
+							paint(simulation, stroke_x, stroke_y, stroke_x, stroke_y, config.brush_radius, e.button.button == SDL_BUTTON_LEFT);
+						}
+					}
+					break;
+				case SDL_MOUSEMOTION:  // continues a stroke from where the last event left it, the middle button drags the board
+					if (e.motion.state & SDL_BUTTON_MMASK) {
+						CellsView_pan(cells_view, snapshot, &viewport, e.motion.xrel, e.motion.yrel);
+					}
+					if (selecting) {
+						size_t cell_x, cell_y;
+						if (CellsView_cell_at(cells_view, snapshot, &viewport, e.motion.x - viewport.x, e.motion.y - viewport.y, &cell_x, &cell_y) == 0) {
+							selection_x1 = cell_x;
+							selection_y1 = cell_y;
+						}
+					}
+					else if (e.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK)) {
+						size_t cell_x, cell_y;
+						int on_board = CellsView_cell_at(cells_view, snapshot, &viewport, e.motion.x - viewport.x, e.motion.y - viewport.y, &cell_x, &cell_y) == 0;
+						if (on_board) {
+							paint(simulation, stroke ? stroke_x : cell_x, stroke ? stroke_y : cell_y, cell_x, cell_y, config.brush_radius, (e.motion.state & SDL_BUTTON_LMASK) != 0);
+							stroke_x = cell_x;
+							stroke_y = cell_y;
+						}
+						stroke = on_board;
+					}
+					break;
+				case SDL_MOUSEBUTTONUP:
+					if (e.button.button == SDL_BUTTON_LEFT) {
+						selecting = 0;
+					}
+					break;
 				case SDL_KEYDOWN:
-					if (e.key.repeat == 0) {
+					// Clipboard lives on the simulation thread, copies are taken from the generation it's at then
+					if (e.key.repeat == 0 && (e.key.keysym.mod & KMOD_CTRL)) {
+						switch (e.key.keysym.sym) {
+							case SDLK_c:  // copies the selection
+							case SDLK_x:  // copies the selection and clears it
+								if (selected) {
+									command.type = e.key.keysym.sym == SDLK_c ? SIMULATION_COPY : SIMULATION_CUT;
+									command.from_x = selection_x0;
+									command.from_y = selection_y0;
+									command.x = selection_x1;
+									command.y = selection_y1;
+									Simulation_send(simulation, &command);
+								}
+								break;
+							case SDLK_v:  // pastes over the cells under the cursor
+								if (cell_under_mouse(cells_view, snapshot, &viewport, &command.x, &command.y) == 0) {
+									command.type = SIMULATION_PASTE;
+									command.value = 0;
+									Simulation_send(simulation, &command);
+								}
+								break;
+						}
+					}
+					else if (e.key.repeat == 0) {
 						switch (e.key.keysym.sym) {
 							case SDLK_ESCAPE:
 								quit = 1;
 								break;
 							case SDLK_p:
-								pause = !pause;
+								command.type = SIMULATION_TOGGLE_PAUSE;
+								Simulation_send(simulation, &command);
 								break;
 							case SDLK_r:  // restarts the entire simulation
-								for (size_t x = 0; x < cells_grid->width; ++x) {
-									for (size_t y = 0; y < cells_grid->height; ++y) {
-										cells_grid->cell[x][y].is_alive = rand() % 2;
-										
-										Uint8 color = cells_grid->cell[x][y].is_alive ? 255 : 0;
-										cells_grid->cell[x][y].r = color;
-										cells_grid->cell[x][y].g = color;
-										cells_grid->cell[x][y].b = color;
-									}
-								}
-								tick = 0;
+								command.type = SIMULATION_RANDOMIZE;
+								Simulation_send(simulation, &command);
 								break;
 							case SDLK_c:  // "clears" the cells grid - makes every cell dead
-								for (size_t x = 0; x < cells_grid->width; ++x) {
-									for (size_t y = 0; y < cells_grid->height; ++y) {
-										cells_grid->cell[x][y].is_alive = 0;
-											
-										cells_grid->cell[x][y].r = 0;
-										cells_grid->cell[x][y].g = 0;
-										cells_grid->cell[x][y].b = 0;
-									}
-								}
-								tick = 0;
+								command.type = SIMULATION_CLEAR;
+								Simulation_send(simulation, &command);
 								break;
 							case SDLK_e:
 								draw_mesh = !draw_mesh;
 								break;
+							case SDLK_s:  // saves the board to a grid file
+								write_board(simulation, &board_writer, BOARD_WRITE_SAVE, snapshot, NULL, config.save_path);
+								break;
+							case SDLK_x:  // exports the board as an RLE or macrocell pattern, depending on the extension
+								write_board(simulation, &board_writer, BOARD_WRITE_EXPORT, snapshot, NULL, config.export_path);
+								break;
+							case SDLK_i:  // saves an image of the whole board
+								write_board(simulation, &board_writer, BOARD_WRITE_SCREENSHOT, snapshot, Gradient_get(gradient_index), config.screenshot_path);
+								break;
+							case SDLK_k:  // writes a checkpoint of the whole simulation state
+								checkpoint_requested = 1;
+								break;
+							case SDLK_g:  // cycles through color gradients
+								gradient_index = (gradient_index + 1) % GRADIENTS_COUNT;
+								break;
+							case SDLK_h:  // shows how often tiles changed lately, tracked only while it's shown
+								draw_heat = !draw_heat;
+								command.type = SIMULATION_SET_HEAT;
+								command.value = draw_heat;
+								Simulation_send(simulation, &command);
+								break;
+							case SDLK_F3:  // shows where frames and the simulation spend their time
+								draw_stats = !draw_stats;
+								break;
 						}
 					}
 
 					switch (e.key.keysym.sym) {
 						case SDLK_RIGHT: // speeds up logic calculations
-							logic_delay -= logic_delay > 0u ? 10u : 0u;
+							rate_index = SDL_min(rate_index + 1, SIMULATION_RATES_COUNT - 1);
+							command.type = SIMULATION_SET_RATE;
+							command.value = SIMULATION_RATES[rate_index];
+							Simulation_send(simulation, &command);
 							break;
 						case SDLK_LEFT:  // slows down logic calculations
-							logic_delay += logic_delay < 990u ? 10u : 0;
+							rate_index = SDL_max(rate_index - 1, 0);
+							command.type = SIMULATION_SET_RATE;
+							command.value = SIMULATION_RATES[rate_index];
+							Simulation_send(simulation, &command);
+							break;
+						case SDLK_t:  // stamps the clipboard's live cells at the cursor, hold to keep stamping
+							if (cell_under_mouse(cells_view, snapshot, &viewport, &command.x, &command.y) == 0) {
+								command.type = SIMULATION_PASTE;
+								command.value = 1;
+								Simulation_send(simulation, &command);
+							}
+							break;
+						case SDLK_BACKSPACE:  // steps back through history, hold to scrub
+							command.type = SIMULATION_REWIND;
+							Simulation_send(simulation, &command);
+							break;
+						case SDLK_PAGEUP:  // seeks back through a recording
+							command.type = SIMULATION_SEEK;
+							command.value = -(Sint64)PLAYER_SEEK_STEP;
+							Simulation_send(simulation, &command);
+							break;
+						case SDLK_PAGEDOWN:  // seeks forward through a recording
+							command.type = SIMULATION_SEEK;
+							command.value = PLAYER_SEEK_STEP;
+							Simulation_send(simulation, &command);
 							break;
 					}
 
 					break;
 			}
-
-			// Change hovered cell state (left button - alive, others - dead)
-			int mouse_x, mouse_y;
-			Uint32 mouse_button = SDL_GetMouseState(&mouse_x, &mouse_y);
-			mouse_x /= g_scale;
-			mouse_y /= g_scale;
-			mouse_x -= viewport.x;
-			mouse_y -= viewport.y;
-
-			if (mouse_button > 0) {
-				for (size_t x = 0; x < cells_grid->width; ++x) {
-					for (size_t y = 0; y < cells_grid->height; ++y) {
-						if (mouse_x >= cells_grid->cell[x][y].pos_x && (unsigned)mouse_x <= cells_grid->cell[x][y].pos_x + cells_grid->cell_size &&
-							mouse_y >= cells_grid->cell[x][y].pos_y && (unsigned)mouse_y <= cells_grid->cell[x][y].pos_y + cells_grid->cell_size) {
-							cells_grid->cell[x][y].is_alive = mouse_button == 1 ? 1 : 0;
-
-							Uint8 color = cells_grid->cell[x][y].is_alive ? 255 : 0;
-							cells_grid->cell[x][y].r = color;
-							cells_grid->cell[x][y].g = color;
-							cells_grid->cell[x][y].b = color;
-						}
-					}
-				}
-			}
 		}
 
-		// Logic
-		logic_current_time = SDL_GetTicks64();
-		if (!pause && logic_current_time > logic_prev_time + logic_delay) {
-			// Count alive neighbours
-			for (size_t x = 0; x < cells_grid->width; ++x) {
-				for (size_t y = 0; y < cells_grid->height; ++y) {
-					cells_grid->cell[x][y].alive_neighbours = 0;
-
-					for (int i = 0; i < DIRECTIONS_SIZE; ++i) {
-						Sint16 x_new = x + directions[i].x;
-						if (x_new < 0) {
-							x_new = cells_grid->width - 1;
-						}
-						else if ((Uint16)x_new > cells_grid->width - 1) {
-							x_new = 0;
-						}
-
-						Sint16 y_new = y + directions[i].y;
-						if (y_new < 0) {
-							y_new = cells_grid->height - 1;
-						}
-						else if ((Uint16)y_new > cells_grid->height - 1) {
-							y_new = 0;
-						}
-
-						cells_grid->cell[x][y].alive_neighbours += cells_grid->cell[x_new][y_new].is_alive ? 1 : 0;
-					}
-				}
-			}
-
-			// Check rules
-			for (size_t x = 0; x < cells_grid->width; ++x) {
-				for (size_t y = 0; y < cells_grid->height; ++y) {
-					if (cells_grid->cell[x][y].is_alive && (cells_grid->cell[x][y].alive_neighbours < 2 || cells_grid->cell[x][y].alive_neighbours > 3)) {
-						cells_grid->cell[x][y].is_alive = 0;
-						
-						cells_grid->cell[x][y].r = 255;
-						cells_grid->cell[x][y].g = 255;
-						cells_grid->cell[x][y].b = 255;
-					}
-					else if (!cells_grid->cell[x][y].is_alive && cells_grid->cell[x][y].alive_neighbours == 3) {
-						cells_grid->cell[x][y].is_alive = 1;
-						
-						cells_grid->cell[x][y].r = 255;
-						cells_grid->cell[x][y].g = 255;
-						cells_grid->cell[x][y].b = 255;
-					}
-
-
-					// Change color accordingly
-					float dr, dg, db;
-					if (cells_grid->cell[x][y].is_alive) {
-						dr = cells_grid->cell[x][y].r > COLOR_ANIM_FACTOR / 8 ? COLOR_ANIM_FACTOR / 8 : 0.0f;
-						dg = cells_grid->cell[x][y].g > COLOR_ANIM_FACTOR / 16 ? COLOR_ANIM_FACTOR / 16 : 0.0f;
-						db = cells_grid->cell[x][y].b > 150 + COLOR_ANIM_FACTOR / 32 ? COLOR_ANIM_FACTOR / 32 : 0.0f;
-					}
-					else {
-						dr = cells_grid->cell[x][y].r > COLOR_ANIM_FACTOR / 4 ? COLOR_ANIM_FACTOR / 4 : 0.0f;
-						dg = cells_grid->cell[x][y].g > COLOR_ANIM_FACTOR / 2 ? COLOR_ANIM_FACTOR / 2 : 0.0f;
-						db = cells_grid->cell[x][y].b > COLOR_ANIM_FACTOR ? COLOR_ANIM_FACTOR : 0.0f;
-					}
-
-					cells_grid->cell[x][y].r -= dr;
-					cells_grid->cell[x][y].g -= dg;
-					cells_grid->cell[x][y].b -= db;
-				}
-			}
-
-			++tick;
+		// Checkpoint on request or every interval, put off while another write is running
+		Uint64 checkpoint_time = SDL_GetTicks64();
+		if ((checkpoint_requested || (config.checkpoint_interval != 0 && checkpoint_time >= checkpoint_prev_time + config.checkpoint_interval * 1000ull))
+			&& !BoardWriter_busy(&board_writer)) {
+			write_board(simulation, &board_writer, BOARD_WRITE_CHECKPOINT, snapshot, NULL, config.checkpoint_path);
+			checkpoint_prev_time = checkpoint_time;
+			checkpoint_requested = 0;
+		}
 
-			logic_prev_time = logic_current_time;
+		// Skipped frames aren't counted, nor is their time
+		Uint64 events_time = Profiler_lap(&profiler);
+		redraw |= snapshot->generation != drawn_generation || snapshot->modification != drawn_modification;
+		idle = !redraw;
+		if (idle) {
+			continue;
 		}
+		Profiler_add(&profiler, PROFILER_EVENTS, events_time);
+		redraw = 0;
+		drawn_generation = snapshot->generation;
+		drawn_modification = snapshot->modification;
 
 		clear_screen(renderer, BLACK_HEX);
 
-		CellsGrid_draw(cells_grid, renderer, &viewport, mesh_texture, draw_mesh);
-
-		// Calculate FPS every second
-		fps_current_time = SDL_GetTicks64();
-		if (fps_current_time > fps_prev_time + 1000) {
-			fps_avg = fps / frame_count + 2;
-			frame_count = 1;
-			fps = 0;
-
-			fps_prev_time = fps_current_time;
-		}
-		else {
-			fps += 1000.0f / (frame_time == 0u ? 1u : frame_time);
-			++frame_count;
+		CellsView_draw(cells_view, snapshot, renderer, &viewport, Gradient_get(gradient_index), draw_mesh, draw_heat);
+		if (selected) {
+			CellsView_draw_selection(cells_view, renderer, &viewport, SDL_min(selection_x0, selection_x1), SDL_min(selection_y0, selection_y1),
+									 SDL_max(selection_x0, selection_x1) - SDL_min(selection_x0, selection_x1) + 1,
+									 SDL_max(selection_y0, selection_y1) - SDL_min(selection_y0, selection_y1) + 1);
 		}
 
 		// Draw GUI
 		if (SDL_RenderSetViewport(renderer, NULL) != 0) {
 			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to set viewport for GUI: %s\n", SDL_GetError());
 		}
-		FC_Draw(font, renderer, 0, 0, "FPS: %d\nTick: %lu\nSpeed: x%.2f\n", fps_avg, tick, (-(logic_delay / 100.0f) + 10.0f) / 10.0f);
+		Hud_set_line(&hud, 0, "FPS: %.0f (jitter %.1f ms)", frame_pacer.fps, frame_pacer.jitter);
+		Hud_set_line(&hud, 1, "Tick: %llu", (unsigned long long)snapshot->generation);
+		if (SIMULATION_RATES[rate_index] != 0) {
+			Hud_set_line(&hud, 2, "Speed: %llu gen/s", (unsigned long long)SIMULATION_RATES[rate_index]);
+		}
+		else {
+			Hud_set_line(&hud, 2, "Speed: max");
+		}
+		if (draw_stats) {
+			Hud_set_line(&hud, 3, "Simulation: %.0f gen/s, %.3g cells/s", profiler.generations_per_second, profiler.cells_per_second);
+			Hud_set_line(&hud, 4, "Step: %.2f ms/gen, %.0f%% busy", profiler.step_time, profiler.step_load * 100.0);
+			Hud_set_line(&hud, 5, "Events %.2f, colors %.2f, render %.2f, present %.2f ms", profiler.phase_times[PROFILER_EVENTS],
+						 profiler.phase_times[PROFILER_COLORS], profiler.phase_times[PROFILER_RENDER], profiler.phase_times[PROFILER_PRESENT]);
+			Hud_set_line(&hud, 6, "Frame p50 %.2f ms, p99 %.2f ms", frame_pacer.frame_time_p50, frame_pacer.frame_time_p99);
+		}
+		else {
+			Hud_set_line_count(&hud, 3);
+		}
+		Hud_draw(&hud, renderer);
+
+		// Texture uploads happen inside drawing the view, they're split off into their own phase
+		Uint64 render_time = Profiler_lap(&profiler);
+		Profiler_add(&profiler, PROFILER_COLORS, cells_view->update_time);
+		Profiler_add(&profiler, PROFILER_RENDER, render_time - SDL_min(render_time, cells_view->update_time));
 
+		// Presenting may wait for vsync, the simulation can publish meanwhile
+		Simulation_release(simulation);
 		SDL_RenderPresent(renderer);
+		Profiler_add(&profiler, PROFILER_PRESENT, Profiler_lap(&profiler));
+		FramePacer_presented(&frame_pacer);
+
+		// Until the first frame is up, board setup included
+		if (startup_start != 0) {
+			Uint64 frequency = SDL_GetPerformanceFrequency();
+			SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Started up in %.1f ms, %.1f ms of it loading the font\n",
+						   (SDL_GetPerformanceCounter() - startup_start) * 1000.0 / frequency, font_time * 1000.0 / frequency);
+			startup_start = 0;
+		}
+		Profiler_frame(&profiler, Simulation_stats(simulation));
 	}
 
-	// Clean up
+	// Clean up, the snapshot being written goes with the simulation
+	if (BoardWriter_finish(&board_writer) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Last write to '%s' failed\n", board_writer.path);
+	}
+	Simulation_delete(simulation);
+	if (history != NULL) {
+		History_delete(history);
+	}
+	if (recorder != NULL && Recorder_close(recorder) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Recording wasn't fully written\n");
+	}
+	if (player != NULL) {
+		Player_delete(player);
+	}
+	CellsView_delete(cells_view);
 	CellsGrid_delete(cells_grid);
 	FC_FreeFont(font);
-  SDL_DestroyTexture(mesh_texture); 
 	close_SDL(window, renderer);
 
 	return 0;
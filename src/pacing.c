@@ -0,0 +1,96 @@
+#include "../include/pacing.h"
+
+static int compare_ticks(const void* a, const void* b) {
+	Uint64 x = *(const Uint64*)a, y = *(const Uint64*)b;
+	return (x > y) - (x < y);
+}
+
+// Sorts a copy of the history, it's done once a second so the frames themselves don't pay for it
+static void update_percentiles(FramePacer* pacer) {
+	Uint64 sorted[PACING_HISTORY_LENGTH];
+	unsigned int count = pacer->history_count;
+	memcpy(sorted, pacer->history, count * sizeof(Uint64));
+	SDL_qsort(sorted, count, sizeof(Uint64), compare_ticks);
+
+	pacer->frame_time_p50 = sorted[(count - 1) / 2] * 1000.0 / pacer->frequency;
+	pacer->frame_time_p99 = sorted[(count - 1) * 99 / 100] * 1000.0 / pacer->frequency;
+}
+
+void FramePacer_init(FramePacer* pacer, int refresh_rate, int vsync) {
+	memset(pacer, 0, sizeof(FramePacer));
+	pacer->frequency = SDL_GetPerformanceFrequency();
+	pacer->period = vsync ? 0 : pacer->frequency / (refresh_rate > 0 ? refresh_rate : PACING_DEFAULT_REFRESH_RATE);
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	pacer->deadline = now;
+	pacer->last_frame = now;
+	pacer->window_start = now;
+}
+
+void FramePacer_wait(FramePacer* pacer) {
+	if (pacer->period == 0) {
+		return;
+	}
+
+	// Frames missed by more than one period are given up on instead of rushed through
+	Uint64 now = SDL_GetPerformanceCounter();
+	pacer->deadline += pacer->period;
+	if (now >= pacer->deadline + pacer->period) {
+		pacer->deadline = now;
+		return;
+	}
+
+	// Sleep is only good to a millisecond, which is taken as jitter rather than spinning a core on the rest.
+	// Rounding down wakes up to a millisecond early instead of late
+	Uint64 milliseconds = pacer->frequency / 1000;
+	if (pacer->deadline >= now + milliseconds) {
+		SDL_Delay((Uint32)((pacer->deadline - now) / milliseconds));
+	}
+}
+
+void FramePacer_presented(FramePacer* pacer) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frame_time = now - pacer->last_frame;
+	pacer->last_frame = now;
+	if (pacer->resumed) {
+		pacer->window_start += frame_time;
+		pacer->resumed = 0;
+		return;
+	}
+
+	++pacer->frames;
+	pacer->sum += frame_time;
+	pacer->sum_squares += (double)frame_time * frame_time;
+	pacer->longest = SDL_max(pacer->longest, frame_time);
+
+	pacer->history[pacer->history_next] = frame_time;
+	pacer->history_next = (pacer->history_next + 1) % PACING_HISTORY_LENGTH;
+	pacer->history_count = SDL_min(pacer->history_count + 1, PACING_HISTORY_LENGTH);
+
+	if (now - pacer->window_start < pacer->frequency) {
+		return;
+	}
+
+	double mean = pacer->sum / pacer->frames;
+	double variance = pacer->sum_squares / pacer->frames - mean * mean;
+	pacer->fps = pacer->frames * (double)pacer->frequency / (now - pacer->window_start);
+	pacer->frame_time = mean * 1000.0 / pacer->frequency;
+	pacer->jitter = SDL_sqrt(variance > 0.0 ? variance : 0.0) * 1000.0 / pacer->frequency;
+	pacer->longest_time = pacer->longest * 1000.0 / pacer->frequency;
+	update_percentiles(pacer);
+
+	pacer->window_start = now;
+	pacer->frames = 0;
+	pacer->sum = 0.0;
+	pacer->sum_squares = 0.0;
+	pacer->longest = 0;
+}
+
+void FramePacer_idled(FramePacer* pacer) {
+	// Nothing was presented since the last frame or idle wait, all of it was idle
+	Uint64 now = SDL_GetPerformanceCounter();
+	pacer->window_start += now - pacer->last_frame;
+	pacer->deadline = now - pacer->period;
+	pacer->last_frame = now;
+	pacer->resumed = 1;
+}
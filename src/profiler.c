@@ -0,0 +1,45 @@
+#include "../include/profiler.h"
+
+void Profiler_init(Profiler* profiler) {
+	memset(profiler, 0, sizeof(Profiler));
+	profiler->frequency = SDL_GetPerformanceFrequency();
+	profiler->lap_start = SDL_GetPerformanceCounter();
+	profiler->window_start = profiler->lap_start;
+}
+
+Uint64 Profiler_lap(Profiler* profiler) {
+	Uint64 now = SDL_GetPerformanceCounter(), ticks = now - profiler->lap_start;
+	profiler->lap_start = now;
+	return ticks;
+}
+
+void Profiler_add(Profiler* profiler, enum ProfilerPhases phase, Uint64 ticks) {
+	profiler->sums[phase] += ticks;
+}
+
+void Profiler_frame(Profiler* profiler, const SimulationStats* stats) {
+	++profiler->frames;
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (now - profiler->window_start < profiler->frequency) {
+		return;
+	}
+
+	double seconds = (double)(now - profiler->window_start) / profiler->frequency;
+	for (int phase = 0; phase < PROFILER_PHASES_COUNT; ++phase) {
+		profiler->phase_times[phase] = profiler->sums[phase] * 1000.0 / profiler->frequency / profiler->frames;
+		profiler->sums[phase] = 0;
+	}
+
+	// Totals only grow, a rewind or seek doesn't take generations back off them
+	Uint64 generations = stats->generations - profiler->window_stats.generations;
+	Uint64 step_time = stats->step_time - profiler->window_stats.step_time;
+	profiler->generations_per_second = generations / seconds;
+	profiler->cells_per_second = (stats->cells - profiler->window_stats.cells) / seconds;
+	profiler->step_time = generations != 0 ? step_time * 1000.0 / profiler->frequency / generations : 0.0;
+	profiler->step_load = step_time / (seconds * profiler->frequency);
+
+	profiler->window_stats = *stats;
+	profiler->window_start = now;
+	profiler->frames = 0;
+}
@@ -0,0 +1,347 @@
+#include "../include/quadtree.h"
+
+static const Uint32 QUADTREE_NO_MEMORY = 0xffffffff;
+
+// Coordinates of levels above this don't fit 64 bits with room to spare
+static const Uint32 QUADTREE_BOUNDS_LEVEL_MAX = 60;
+
+QuadTree* QuadTree_create(void) {
+	QuadTree* quadtree = calloc(1, sizeof(QuadTree));
+	if (quadtree == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for quadtree\n");
+		return NULL;
+	}
+
+	quadtree->node_capacity = 1024;
+	quadtree->table_capacity = 2048;
+	quadtree->nodes = malloc(sizeof(QuadNode) * quadtree->node_capacity);
+	quadtree->table = calloc(quadtree->table_capacity, sizeof(Uint32));
+	if (quadtree->nodes == NULL || quadtree->table == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for quadtree nodes\n");
+		QuadTree_delete(quadtree);
+		return NULL;
+	}
+
+	// Node 0 is the shared empty node
+	memset(&quadtree->nodes[QUADTREE_EMPTY], 0, sizeof(QuadNode));
+	quadtree->node_count = 1;
+	quadtree->root = QUADTREE_EMPTY;
+	quadtree->root_level = QUADTREE_LEAF_LEVEL;
+	quadtree->rule = RULE_CONWAY;
+
+	return quadtree;
+}
+
+void QuadTree_delete(QuadTree* quadtree) {
+	free(quadtree->nodes);
+	free(quadtree->table);
+	free(quadtree);
+}
+
+static inline Uint64 mix(Uint64 hash) {
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static inline Uint64 hash_node(const QuadNode* node) {
+	if (node->level == QUADTREE_LEAF_LEVEL) {
+		return mix(node->leaf ^ 0x9e3779b97f4a7c15ull);
+	}
+
+	Uint64 hash = node->level;
+	for (int i = 0; i < 4; ++i) {
+		hash = mix(hash * 0x100000001b3ull + node->child[i]);
+	}
+	return hash;
+}
+
+static inline int equal_nodes(const QuadNode* a, const QuadNode* b) {
+	if (a->level != b->level) {
+		return 0;
+	}
+	if (a->level == QUADTREE_LEAF_LEVEL) {
+		return a->leaf == b->leaf;
+	}
+
+	return memcmp(a->child, b->child, sizeof(a->child)) == 0;
+}
+
+static int grow_table(QuadTree* quadtree) {
+	size_t capacity = quadtree->table_capacity * 2;
+	Uint32* table = calloc(capacity, sizeof(Uint32));
+	if (table == NULL) {
+		return -1;
+	}
+
+	for (size_t i = 1; i < quadtree->node_count; ++i) {
+		size_t slot = hash_node(&quadtree->nodes[i]) & (capacity - 1);
+		while (table[slot] != 0) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+		table[slot] = i;
+	}
+
+	free(quadtree->table);
+	quadtree->table = table;
+	quadtree->table_capacity = capacity;
+	return 0;
+}
+
+// Finds node equal to the given one or adds it
+static Uint32 intern(QuadTree* quadtree, const QuadNode* node) {
+	size_t mask = quadtree->table_capacity - 1;
+	size_t slot = hash_node(node) & mask;
+	while (quadtree->table[slot] != 0) {
+		if (equal_nodes(&quadtree->nodes[quadtree->table[slot]], node)) {
+			return quadtree->table[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	if (quadtree->node_count >= QUADTREE_NO_MEMORY - 1) {
+		return QUADTREE_NO_MEMORY;
+	}
+	if (quadtree->node_count == quadtree->node_capacity) {
+		QuadNode* nodes = realloc(quadtree->nodes, sizeof(QuadNode) * quadtree->node_capacity * 2);
+		if (nodes == NULL) {
+			return QUADTREE_NO_MEMORY;
+		}
+		quadtree->nodes = nodes;
+		quadtree->node_capacity *= 2;
+	}
+
+	Uint32 index = quadtree->node_count++;
+	quadtree->nodes[index] = *node;
+	quadtree->table[slot] = index;
+
+	// Keep the table at most half full
+	if (quadtree->node_count * 2 > quadtree->table_capacity && grow_table(quadtree) != 0) {
+		return QUADTREE_NO_MEMORY;
+	}
+
+	return index;
+}
+
+Uint32 QuadTree_leaf(QuadTree* quadtree, Uint64 cells) {
+	if (cells == 0) {
+		return QUADTREE_EMPTY;
+	}
+
+	QuadNode node = {QUADTREE_LEAF_LEVEL, {0, 0, 0, 0}, cells};
+	return intern(quadtree, &node);
+}
+
+Uint32 QuadTree_node(QuadTree* quadtree, Uint32 level, Uint32 nw, Uint32 ne, Uint32 sw, Uint32 se) {
+	if ((nw | ne | sw | se) == QUADTREE_EMPTY) {
+		return QUADTREE_EMPTY;
+	}
+
+	QuadNode node = {level, {nw, ne, sw, se}, 0};
+	return intern(quadtree, &node);
+}
+
+// Reads 8x8 cells with top left corner at (x, y), x being a multiple of 8. Parts outside of the grid are dead
+static Uint64 read_block(const CellsGrid* cells_grid, size_t x, size_t y) {
+	if (x >= cells_grid->width) {
+		return 0;
+	}
+
+	Uint64 cells = 0;
+	size_t rows = SDL_min((size_t)8, cells_grid->height - SDL_min(y, cells_grid->height));
+	for (size_t row = 0; row < rows; ++row) {
+		Uint64 byte = (CellsGrid_row(cells_grid, y + row)[x / CELLS_WORD_BITS] >> (x % CELLS_WORD_BITS)) & 0xff;
+		cells |= byte << (row * 8);
+	}
+
+	return cells;
+}
+
+static Uint32 build(QuadTree* quadtree, const CellsGrid* cells_grid, Uint32 level, size_t x, size_t y) {
+	if (x >= cells_grid->width || y >= cells_grid->height) {
+		return QUADTREE_EMPTY;
+	}
+	if (level == QUADTREE_LEAF_LEVEL) {
+		return QuadTree_leaf(quadtree, read_block(cells_grid, x, y));
+	}
+
+	size_t half = (size_t)1 << (level - 1);
+	Uint32 nw = build(quadtree, cells_grid, level - 1, x, y);
+	Uint32 ne = build(quadtree, cells_grid, level - 1, x + half, y);
+	Uint32 sw = build(quadtree, cells_grid, level - 1, x, y + half);
+	Uint32 se = build(quadtree, cells_grid, level - 1, x + half, y + half);
+	if (nw == QUADTREE_NO_MEMORY || ne == QUADTREE_NO_MEMORY || sw == QUADTREE_NO_MEMORY || se == QUADTREE_NO_MEMORY) {
+		return QUADTREE_NO_MEMORY;
+	}
+
+	return QuadTree_node(quadtree, level, nw, ne, sw, se);
+}
+
+QuadTree* QuadTree_from_grid(const CellsGrid* cells_grid) {
+	QuadTree* quadtree = QuadTree_create();
+	if (quadtree == NULL) {
+		return NULL;
+	}
+
+	Uint32 level = QUADTREE_LEAF_LEVEL;
+	while (((size_t)1 << level) < cells_grid->width || ((size_t)1 << level) < cells_grid->height) {
+		++level;
+	}
+
+	quadtree->root = build(quadtree, cells_grid, level, 0, 0);
+	quadtree->root_level = level;
+	quadtree->rule = cells_grid->rule;
+	quadtree->generation = cells_grid->generation;
+	if (quadtree->root == QUADTREE_NO_MEMORY) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Ran out of memory building quadtree\n");
+		QuadTree_delete(quadtree);
+		return NULL;
+	}
+
+	return quadtree;
+}
+
+typedef struct BoundsStruct {
+	Sint64 min_x, min_y, max_x, max_y;  // inclusive, min > max if not computed yet
+} Bounds;
+
+// Bounding box of a node relative to its corner, memoized per distinct node
+static Bounds node_bounds(const QuadTree* quadtree, Bounds* memo, Uint32 index) {
+	if (memo[index].min_x <= memo[index].max_x) {
+		return memo[index];
+	}
+
+	const QuadNode* node = &quadtree->nodes[index];
+	Bounds bounds = {INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN};
+
+	if (node->level == QUADTREE_LEAF_LEVEL) {
+		for (int y = 0; y < 8; ++y) {
+			for (int x = 0; x < 8; ++x) {
+				if (node->leaf >> (y * 8 + x) & 1) {
+					bounds.min_x = SDL_min(bounds.min_x, x);
+					bounds.min_y = SDL_min(bounds.min_y, y);
+					bounds.max_x = SDL_max(bounds.max_x, x);
+					bounds.max_y = SDL_max(bounds.max_y, y);
+				}
+			}
+		}
+	}
+	else {
+		Sint64 half = (Sint64)1 << (node->level - 1);
+		for (int i = 0; i < 4; ++i) {
+			if (node->child[i] == QUADTREE_EMPTY) {
+				continue;
+			}
+
+			Bounds child = node_bounds(quadtree, memo, node->child[i]);
+			Sint64 offset_x = (i & 1) * half, offset_y = (i >> 1) * half;
+			bounds.min_x = SDL_min(bounds.min_x, child.min_x + offset_x);
+			bounds.min_y = SDL_min(bounds.min_y, child.min_y + offset_y);
+			bounds.max_x = SDL_max(bounds.max_x, child.max_x + offset_x);
+			bounds.max_y = SDL_max(bounds.max_y, child.max_y + offset_y);
+		}
+	}
+
+	memo[index] = bounds;
+	return bounds;
+}
+
+int QuadTree_bounds(const QuadTree* quadtree, Sint64* x, Sint64* y, Sint64* width, Sint64* height) {
+	if (quadtree->root == QUADTREE_EMPTY || quadtree->root_level > QUADTREE_BOUNDS_LEVEL_MAX) {
+		return -1;
+	}
+
+	Bounds* memo = malloc(sizeof(Bounds) * quadtree->node_count);
+	if (memo == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for quadtree bounds\n");
+		return -1;
+	}
+	for (size_t i = 0; i < quadtree->node_count; ++i) {
+		memo[i] = (Bounds){1, 1, 0, 0};
+	}
+
+	Bounds bounds = node_bounds(quadtree, memo, quadtree->root);
+	free(memo);
+
+	*x = bounds.min_x;
+	*y = bounds.min_y;
+	*width = bounds.max_x - bounds.min_x + 1;
+	*height = bounds.max_y - bounds.min_y + 1;
+	return 0;
+}
+
+// Writes node with top left corner at (x, y) in grid coordinates, the caller made sure it's inside the grid
+static void flatten(const QuadTree* quadtree, CellsGrid* cells_grid, Uint32 index, Sint64 x, Sint64 y) {
+	const QuadNode* node = &quadtree->nodes[index];
+	Sint64 size = (Sint64)1 << node->level;
+
+	// Skip parts outside of the grid, only possible around the bounding box
+	if (x >= (Sint64)cells_grid->width || y >= (Sint64)cells_grid->height || x + size <= 0 || y + size <= 0) {
+		return;
+	}
+
+	if (node->level > QUADTREE_LEAF_LEVEL) {
+		Sint64 half = size / 2;
+		for (int i = 0; i < 4; ++i) {
+			if (node->child[i] != QUADTREE_EMPTY) {
+				flatten(quadtree, cells_grid, node->child[i], x + (i & 1) * half, y + (i >> 1) * half);
+			}
+		}
+		return;
+	}
+
+	for (Sint64 row = 0; row < 8; ++row) {
+		CellsWord byte = (node->leaf >> (row * 8)) & 0xff;
+		if (byte == 0 || y + row < 0 || y + row >= (Sint64)cells_grid->height) {
+			continue;
+		}
+
+		// Leaves can hang over the edges of the grid, the cells there are dead anyway
+		CellsWord* cells = CellsGrid_row(cells_grid, y + row);
+		for (Sint64 column = 0; column < 8; ++column) {
+			Sint64 cell_x = x + column;
+			if ((byte >> column & 1) && cell_x >= 0 && cell_x < (Sint64)cells_grid->width) {
+				cells[cell_x / CELLS_WORD_BITS] |= (CellsWord)1 << (cell_x % CELLS_WORD_BITS);
+			}
+		}
+	}
+}
+
+int QuadTree_flatten(const QuadTree* quadtree, CellsGrid* cells_grid, int centered, long long x, long long y) {
+	Sint64 bounds_x, bounds_y, width, height;
+	if (QuadTree_bounds(quadtree, &bounds_x, &bounds_y, &width, &height) != 0) {
+		if (quadtree->root != QUADTREE_EMPTY) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pattern of level %u is too big to flatten\n", quadtree->root_level);
+			return -1;
+		}
+		width = height = 0;
+	}
+
+	if (width > (Sint64)cells_grid->width || height > (Sint64)cells_grid->height) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pattern of %lldx%lld cells doesn't fit %zux%zu board\n",
+					 (long long)width, (long long)height, cells_grid->width, cells_grid->height);
+		return -1;
+	}
+	if (centered) {
+		x = ((Sint64)cells_grid->width - width) / 2;
+		y = ((Sint64)cells_grid->height - height) / 2;
+	}
+
+	cells_grid->rule = quadtree->rule;
+	if (width == 0) {
+		return 0;
+	}
+
+	// Root is placed so that its bounding box lands at (x, y)
+	flatten(quadtree, cells_grid, quadtree->root, x - bounds_x, y - bounds_y);
+	CellsGrid_set_generation(cells_grid, quadtree->generation);
+
+	Sint64 x0 = SDL_max(x, 0), y0 = SDL_max(y, 0);
+	Sint64 x1 = SDL_min(x + width, (Sint64)cells_grid->width), y1 = SDL_min(y + height, (Sint64)cells_grid->height);
+	if (x0 < x1 && y0 < y1) {
+		CellsGrid_touch(cells_grid, x0, y0, x1 - x0, y1 - y0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,711 @@
+#include "../include/recording.h"
+#include "../include/runs.h"
+
+static const char RECORDING_MAGIC[8] = "GOLREC";
+static const char RECORDING_INDEX_MAGIC[8] = "GOLRIDX";
+static const Uint32 RECORDING_VERSION = 1;
+static const Uint32 RECORDING_BYTE_ORDER = 0x01020304;
+
+// Blocks are handed to the writer once they're this full
+static const size_t RECORDER_BLOCK_SIZE = 1 << 20;
+
+// Longest stretch of deltas between keyframes, bounds the cost of seeking
+static const Uint64 RECORDER_KEYFRAME_INTERVAL = 256;
+
+// Most a word's runs of one kind can take, 32 runs of a length and a gap
+static const size_t RECORDER_WORD_RUNS_BOUND = 32 * 2 * 10;
+
+// Written as is, followed by the records
+typedef struct RecordingHeaderStruct {
+	char magic[8];
+	Uint32 version;
+	Uint32 byte_order;
+	Uint64 width, height;
+	char rule[32];
+} RecordingHeader;
+
+// Every record starts with its kind, generation and payload size. A keyframe holds the run-length coded board
+// (raw if that isn't smaller), a delta per changed row its gap from the previous one, then runs of births and
+// runs of deaths, each a length and the gap from the previous run's end, ended by a 0 length. The index holds
+// its entry count, then per keyframe its generation, the last generation before the next one and its offset
+enum RecordKinds {
+	RECORD_KEYFRAME = 'K',
+	RECORD_DELTA = 'D',
+	RECORD_INDEX = 'I'
+};
+
+#define RECORD_HEADER_SIZE (1 + 2 * sizeof(Uint64))
+
+// Ends the stream, after the index record
+typedef struct RecordingTrailerStruct {
+	Uint64 index_offset;
+	char magic[8];
+} RecordingTrailer;
+
+static inline size_t grid_words(const CellsGrid* cells_grid) {
+	return cells_grid->words_per_row * cells_grid->height;
+}
+
+// Writes handed over blocks until told to quit with none left
+static int write_blocks(void* data) {
+	Recorder* recorder = data;
+
+	SDL_LockMutex(recorder->lock);
+	for (;;) {
+		while (recorder->pending_size == 0 && !recorder->quit) {
+			SDL_CondWait(recorder->block_ready, recorder->lock);
+		}
+		if (recorder->pending_size == 0) {
+			break;
+		}
+
+		// The active block is never the one being written, so the lock isn't held for the write
+		const Uint8* block = recorder->blocks[!recorder->active];
+		size_t size = recorder->pending_size;
+		SDL_UnlockMutex(recorder->lock);
+		int failed = fwrite(block, 1, size, recorder->file) != size;
+		SDL_LockMutex(recorder->lock);
+
+		recorder->failed |= failed;
+		recorder->pending_size = 0;
+		SDL_CondSignal(recorder->block_ready);
+	}
+	SDL_UnlockMutex(recorder->lock);
+
+	return 0;
+}
+
+// Swaps the blocks, waiting for the previous one to be written first
+static void hand_over(Recorder* recorder) {
+	if (recorder->filled == 0) {
+		return;
+	}
+
+	SDL_LockMutex(recorder->lock);
+	while (recorder->pending_size != 0) {
+		SDL_CondWait(recorder->block_ready, recorder->lock);
+	}
+	recorder->pending_size = recorder->filled;
+	recorder->active = !recorder->active;
+	SDL_CondSignal(recorder->block_ready);
+	SDL_UnlockMutex(recorder->lock);
+
+	recorder->offset += recorder->filled;
+	recorder->filled = 0;
+}
+
+// Makes room for size more bytes in the active block, it can grow past the block size for big keyframes
+static Uint8* reserve(Recorder* recorder, size_t size) {
+	size_t* capacity = &recorder->block_capacities[recorder->active];
+	if (recorder->filled + size > *capacity) {
+		size_t new_capacity = SDL_max(recorder->filled + size, *capacity * 2);
+		Uint8* block = realloc(recorder->blocks[recorder->active], new_capacity);
+		if (block == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for recording block\n");
+			return NULL;
+		}
+		recorder->blocks[recorder->active] = block;
+		*capacity = new_capacity;
+	}
+
+	return recorder->blocks[recorder->active] + recorder->filled;
+}
+
+static void put_record_header(Uint8* out, Uint8 kind, Uint64 generation, Uint64 size) {
+	out[0] = kind;
+	memcpy(out + 1, &generation, sizeof(generation));
+	memcpy(out + 1 + sizeof(generation), &size, sizeof(size));
+}
+
+static int add_to_index(Recorder* recorder, Uint64 generation, Uint64 offset) {
+	if (recorder->index_count == recorder->index_capacity) {
+		size_t capacity = SDL_max((size_t)64, recorder->index_capacity * 2);
+		RecordingKeyframe* index = realloc(recorder->index, sizeof(RecordingKeyframe) * capacity);
+		if (index == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for recording index\n");
+			return -1;
+		}
+		recorder->index = index;
+		recorder->index_capacity = capacity;
+	}
+
+	recorder->index[recorder->index_count++] = (RecordingKeyframe){generation, generation, offset};
+	return 0;
+}
+
+static int record_keyframe(Recorder* recorder, const CellsGrid* cells_grid) {
+	size_t words = grid_words(cells_grid);
+	size_t raw_size = words * sizeof(CellsWord);
+	Uint8* out = reserve(recorder, RECORD_HEADER_SIZE + raw_size);
+	if (out == NULL || add_to_index(recorder, cells_grid->generation, recorder->offset + recorder->filled) != 0) {
+		return -1;
+	}
+
+	size_t length = Runs_encode_words(cells_grid->cells, words, out + RECORD_HEADER_SIZE, raw_size - 1);
+	if (length == 0) {
+		memcpy(out + RECORD_HEADER_SIZE, cells_grid->cells, raw_size);
+		length = raw_size;
+	}
+	put_record_header(out, RECORD_KEYFRAME, cells_grid->generation, length);
+	recorder->filled += RECORD_HEADER_SIZE + length;
+
+	memcpy(recorder->shadow, cells_grid->cells, raw_size);
+	recorder->keyframe_generation = cells_grid->generation;
+	return 0;
+}
+
+// Most values are small, so the common case of a single byte skips the general varint code
+static inline Uint8* put_small(Uint8* out, size_t value) {
+	if (value < 0x80) {
+		*out = value;
+		return out + 1;
+	}
+	return out + Runs_put_varint(out, value);
+}
+
+// Writes the runs of set bits of one row's words in the listed columns, runs crossing into the next word go on
+// through it. Every change from the previous bit, carried over from an adjacent word, starts or ends a run
+static Uint8* put_runs(Uint8* out, const CellsWord* old, const CellsWord* new, const size_t* columns, size_t column_count, int deaths) {
+	size_t previous_end = 0, start = 0;
+	size_t previous_x = SIZE_MAX - 1;
+	CellsWord previous_top = 0;
+
+	for (size_t i = 0; i < column_count; ++i) {
+		size_t x = columns[i];
+		CellsWord word = deaths ? old[x] & ~new[x] : new[x] & ~old[x];
+		CellsWord carry = x == previous_x + 1 ? previous_top : 0;
+		if (previous_top && !carry) {
+			size_t end = (previous_x + 1) * CELLS_WORD_BITS;
+			out = put_small(put_small(out, end - start), start - previous_end);
+			previous_end = end;
+		}
+
+		// Edges alternate between starts and ends, a run carried in from the previous word starts with an end
+		CellsWord edges = word ^ ((word << 1) | carry);
+		if (carry && edges != 0) {
+			size_t end = x * CELLS_WORD_BITS + __builtin_ctzll(edges);
+			out = put_small(put_small(out, end - start), start - previous_end);
+			previous_end = end;
+			edges &= edges - 1;
+		}
+		while (edges != 0) {
+			start = x * CELLS_WORD_BITS + __builtin_ctzll(edges);
+			edges &= edges - 1;
+			if (edges == 0) {
+				break;
+			}
+			size_t end = x * CELLS_WORD_BITS + __builtin_ctzll(edges);
+			edges &= edges - 1;
+			out = put_small(put_small(out, end - start), start - previous_end);
+			previous_end = end;
+		}
+
+		previous_x = x;
+		previous_top = word >> (CELLS_WORD_BITS - 1);
+	}
+
+	if (previous_top) {
+		size_t end = (previous_x + 1) * CELLS_WORD_BITS;
+		out = put_small(put_small(out, end - start), start - previous_end);
+	}
+	*out = 0;
+	return out + 1;
+}
+
+static int record_delta(Recorder* recorder, const CellsGrid* cells_grid) {
+	Uint8* header = reserve(recorder, RECORD_HEADER_SIZE);
+	if (header == NULL) {
+		return -1;
+	}
+	size_t payload_start = recorder->filled + RECORD_HEADER_SIZE;
+	recorder->filled = payload_start;
+
+	size_t next_row = 0;
+	for (size_t tile_y = 0; tile_y < cells_grid->tiles_y; ++tile_y) {
+		size_t column_count = 0;
+		for (size_t tile_x = 0; tile_x < cells_grid->tiles_x; ++tile_x) {
+			if (cells_grid->tile_modification[tile_y * cells_grid->tiles_x + tile_x] > recorder->modification) {
+				recorder->columns[column_count++] = tile_x;
+			}
+		}
+		if (column_count == 0) {
+			continue;
+		}
+
+		size_t y1 = SDL_min((tile_y + 1) * CELLS_TILE_ROWS, cells_grid->height);
+		for (size_t y = tile_y * CELLS_TILE_ROWS; y < y1; ++y) {
+			Uint8* row_start = reserve(recorder, 3 * 10 + column_count * 2 * RECORDER_WORD_RUNS_BOUND);
+			if (row_start == NULL) {
+				return -1;
+			}
+
+			CellsWord* old = recorder->shadow + y * cells_grid->words_per_row;
+			const CellsWord* new = CellsGrid_row(cells_grid, y);
+			size_t gap_size = Runs_put_varint(row_start, y - next_row);
+			Uint8* out = put_runs(row_start + gap_size, old, new, recorder->columns, column_count, 0);
+			out = put_runs(out, old, new, recorder->columns, column_count, 1);
+
+			for (size_t i = 0; i < column_count; ++i) {
+				old[recorder->columns[i]] = new[recorder->columns[i]];
+			}
+
+			// Rows that didn't change are left out, all they got is the gap and two empty lists
+			if ((size_t)(out - row_start) > gap_size + 2) {
+				recorder->filled += out - row_start;
+				next_row = y + 1;
+			}
+		}
+	}
+
+	header = recorder->blocks[recorder->active] + payload_start - RECORD_HEADER_SIZE;
+	put_record_header(header, RECORD_DELTA, cells_grid->generation, recorder->filled - payload_start);
+	return 0;
+}
+
+Recorder* Recorder_create(const CellsGrid* cells_grid, const char* path) {
+	Recorder* recorder = calloc(1, sizeof(Recorder));
+	if (recorder == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for recorder\n");
+		return NULL;
+	}
+
+	recorder->file = fopen(path, "wb");
+	if (recorder->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open recording '%s'\n", path);
+		free(recorder);
+		return NULL;
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		recorder->blocks[i] = malloc(RECORDER_BLOCK_SIZE);
+		recorder->block_capacities[i] = RECORDER_BLOCK_SIZE;
+	}
+	recorder->shadow = malloc(sizeof(CellsWord) * grid_words(cells_grid));
+	recorder->columns = malloc(sizeof(size_t) * cells_grid->tiles_x);
+	recorder->lock = SDL_CreateMutex();
+	recorder->block_ready = SDL_CreateCond();
+	if (recorder->blocks[0] == NULL || recorder->blocks[1] == NULL || recorder->shadow == NULL || recorder->columns == NULL ||
+		recorder->lock == NULL || recorder->block_ready == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for recorder\n");
+		Recorder_close(recorder);
+		return NULL;
+	}
+
+	RecordingHeader header = {0};
+	memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+	header.version = RECORDING_VERSION;
+	header.byte_order = RECORDING_BYTE_ORDER;
+	header.width = cells_grid->width;
+	header.height = cells_grid->height;
+	Rule_format(cells_grid->rule, header.rule, sizeof(header.rule));
+	memcpy(recorder->blocks[0], &header, sizeof(header));
+	recorder->filled = sizeof(header);
+
+	if (record_keyframe(recorder, cells_grid) != 0) {
+		Recorder_close(recorder);
+		return NULL;
+	}
+	recorder->modification = cells_grid->modification;
+	recorder->generation = cells_grid->generation;
+
+	recorder->thread = SDL_CreateThread(write_blocks, "recording writer", recorder);
+	if (recorder->thread == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start recording writer: %s\n", SDL_GetError());
+		Recorder_close(recorder);
+		return NULL;
+	}
+
+	return recorder;
+}
+
+int Recorder_record(Recorder* recorder, const CellsGrid* cells_grid) {
+	if (cells_grid->modification == recorder->modification && cells_grid->generation == recorder->generation) {
+		return 0;
+	}
+
+	// Anything but the next generation can't be a delta
+	int result;
+	if (cells_grid->generation != recorder->generation + 1 || cells_grid->generation - recorder->keyframe_generation >= RECORDER_KEYFRAME_INTERVAL) {
+		result = record_keyframe(recorder, cells_grid);
+	}
+	else {
+		result = record_delta(recorder, cells_grid);
+	}
+	recorder->modification = cells_grid->modification;
+	recorder->generation = cells_grid->generation;
+	recorder->index[recorder->index_count - 1].last_generation = cells_grid->generation;
+
+	if (recorder->filled >= RECORDER_BLOCK_SIZE) {
+		hand_over(recorder);
+	}
+
+	return result;
+}
+
+static int write_index(Recorder* recorder) {
+	Uint64 index_offset = recorder->offset + recorder->filled;
+	Uint8* out = reserve(recorder, RECORD_HEADER_SIZE + 10 + recorder->index_count * 3 * 10 + sizeof(RecordingTrailer));
+	if (out == NULL) {
+		return -1;
+	}
+
+	Uint8* payload = out + RECORD_HEADER_SIZE;
+	Uint8* end = payload + Runs_put_varint(payload, recorder->index_count);
+	for (size_t i = 0; i < recorder->index_count; ++i) {
+		end += Runs_put_varint(end, recorder->index[i].generation);
+		end += Runs_put_varint(end, recorder->index[i].last_generation);
+		end += Runs_put_varint(end, recorder->index[i].offset);
+	}
+	put_record_header(out, RECORD_INDEX, 0, end - payload);
+
+	RecordingTrailer trailer = {index_offset, {0}};
+	memcpy(trailer.magic, RECORDING_INDEX_MAGIC, sizeof(trailer.magic));
+	memcpy(end, &trailer, sizeof(trailer));
+	recorder->filled += end + sizeof(trailer) - out;
+	return 0;
+}
+
+int Recorder_close(Recorder* recorder) {
+	int failed = 0;
+	if (recorder->thread != NULL) {
+		failed = write_index(recorder) != 0;
+		hand_over(recorder);
+
+		SDL_LockMutex(recorder->lock);
+		recorder->quit = 1;
+		SDL_CondSignal(recorder->block_ready);
+		SDL_UnlockMutex(recorder->lock);
+		SDL_WaitThread(recorder->thread, NULL);
+	}
+
+	failed |= recorder->failed;
+	if (fclose(recorder->file) != 0) {
+		failed = 1;
+	}
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write recording\n");
+	}
+
+	SDL_DestroyCond(recorder->block_ready);
+	SDL_DestroyMutex(recorder->lock);
+	free(recorder->blocks[0]);
+	free(recorder->blocks[1]);
+	free(recorder->shadow);
+	free(recorder->columns);
+	free(recorder->index);
+	free(recorder);
+
+	return failed ? -1 : 0;
+}
+
+static int read_record_header(Player* player, Uint8* kind, Uint64* generation, Uint64* size) {
+	Uint8 header[RECORD_HEADER_SIZE];
+	if (SDL_RWread(player->file, header, sizeof(header), 1) != 1) {
+		return -1;
+	}
+
+	*kind = header[0];
+	memcpy(generation, header + 1, sizeof(*generation));
+	memcpy(size, header + 1 + sizeof(*generation), sizeof(*size));
+	return 0;
+}
+
+static Uint8* read_payload(Player* player, Uint64 size) {
+	if (size > player->buffer_capacity) {
+		Uint8* buffer = realloc(player->buffer, size);
+		if (buffer == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for recording record\n");
+			return NULL;
+		}
+		player->buffer = buffer;
+		player->buffer_capacity = size;
+	}
+
+	if (size != 0 && SDL_RWread(player->file, player->buffer, size, 1) != 1) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Recording is truncated\n");
+		return NULL;
+	}
+	return player->buffer;
+}
+
+static int set_index_capacity(Player* player, size_t capacity) {
+	RecordingKeyframe* index = realloc(player->index, sizeof(RecordingKeyframe) * capacity);
+	if (index == NULL) {
+		return -1;
+	}
+	player->index = index;
+	return 0;
+}
+
+// Reads the index the trailer points at. Returns 0 on success
+static int read_index(Player* player, Sint64 file_size) {
+	RecordingTrailer trailer;
+	if (file_size < (Sint64)(player->data_start + RECORD_HEADER_SIZE + sizeof(trailer)) ||
+		SDL_RWseek(player->file, file_size - sizeof(trailer), RW_SEEK_SET) < 0 || SDL_RWread(player->file, &trailer, sizeof(trailer), 1) != 1 ||
+		memcmp(trailer.magic, RECORDING_INDEX_MAGIC, sizeof(trailer.magic)) != 0 || trailer.index_offset < player->data_start ||
+		trailer.index_offset > (Uint64)file_size - sizeof(trailer) - RECORD_HEADER_SIZE) {
+		return -1;
+	}
+
+	Uint8 kind;
+	Uint64 generation, size;
+	if (SDL_RWseek(player->file, trailer.index_offset, RW_SEEK_SET) < 0 || read_record_header(player, &kind, &generation, &size) != 0 ||
+		kind != RECORD_INDEX || size != (Uint64)file_size - sizeof(trailer) - RECORD_HEADER_SIZE - trailer.index_offset) {
+		return -1;
+	}
+
+	const Uint8* in = read_payload(player, size);
+	const Uint8* end = in + size;
+	Uint64 count;
+	in = in != NULL ? Runs_get_varint(in, end, &count) : NULL;
+	if (in == NULL || count > size / 3 || (count != 0 && set_index_capacity(player, count) != 0)) {
+		return -1;
+	}
+	for (size_t i = 0; i < count && in != NULL; ++i) {
+		RecordingKeyframe* keyframe = &player->index[i];
+		in = Runs_get_varint(in, end, &keyframe->generation);
+		in = in != NULL ? Runs_get_varint(in, end, &keyframe->last_generation) : NULL;
+		in = in != NULL ? Runs_get_varint(in, end, &keyframe->offset) : NULL;
+		if (in != NULL && (keyframe->offset < player->data_start || keyframe->offset >= trailer.index_offset)) {
+			in = NULL;
+		}
+	}
+	if (in != end) {
+		return -1;
+	}
+
+	player->index_count = count;
+	player->data_end = trailer.index_offset;
+	return 0;
+}
+
+// Rebuilds the index of a stream that was never closed, it ends at the last record that was fully written
+static int scan_index(Player* player, Sint64 file_size) {
+	player->index_count = 0;
+	size_t capacity = 0;
+	Uint64 offset = player->data_start;
+	Uint8 kind;
+	Uint64 generation, size;
+
+	while (SDL_RWseek(player->file, offset, RW_SEEK_SET) >= 0 && read_record_header(player, &kind, &generation, &size) == 0 &&
+		   (kind == RECORD_KEYFRAME || kind == RECORD_DELTA) && size <= (Uint64)file_size - offset - RECORD_HEADER_SIZE) {
+		if (kind == RECORD_KEYFRAME) {
+			if (player->index_count == capacity) {
+				capacity = SDL_max((size_t)64, capacity * 2);
+				if (set_index_capacity(player, capacity) != 0) {
+					return -1;
+				}
+			}
+			player->index[player->index_count++] = (RecordingKeyframe){generation, generation, offset};
+		}
+		else if (player->index_count != 0) {
+			player->index[player->index_count - 1].last_generation = generation;
+		}
+		offset += RECORD_HEADER_SIZE + size;
+	}
+
+	player->data_end = offset;
+	return 0;
+}
+
+Player* Player_open(const char* path) {
+	Player* player = calloc(1, sizeof(Player));
+	if (player == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for player\n");
+		return NULL;
+	}
+
+	player->file = SDL_RWFromFile(path, "rb");
+	if (player->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open recording '%s': %s\n", path, SDL_GetError());
+		free(player);
+		return NULL;
+	}
+
+	RecordingHeader header;
+	const char* error = NULL;
+	if (SDL_RWread(player->file, &header, sizeof(header), 1) != 1 || memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0) {
+		error = "not a recording";
+	}
+	else if (header.version != RECORDING_VERSION) {
+		error = "unsupported version";
+	}
+	else if (header.byte_order != RECORDING_BYTE_ORDER) {
+		error = "written on a machine of other endianness";
+	}
+	else if (header.width == 0 || header.height == 0 || header.width > SIZE_MAX / header.height) {
+		error = "invalid board size";
+	}
+	else {
+		header.rule[sizeof(header.rule) - 1] = '\0';
+		if (Rule_parse(header.rule, &player->rule) != 0) {
+			error = "invalid rule";
+		}
+	}
+
+	if (error == NULL) {
+		player->width = header.width;
+		player->height = header.height;
+		player->data_start = sizeof(header);
+
+		Sint64 file_size = SDL_RWsize(player->file);
+		if (file_size < 0 || (read_index(player, file_size) != 0 && scan_index(player, file_size) != 0)) {
+			error = "failed to read its index";
+		}
+		else if (player->index_count == 0) {
+			error = "no keyframes";
+		}
+		else if (SDL_RWseek(player->file, player->data_start, RW_SEEK_SET) < 0) {
+			error = "failed to seek";
+		}
+	}
+
+	if (error != NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open recording '%s': %s\n", path, error);
+		Player_delete(player);
+		return NULL;
+	}
+
+	return player;
+}
+
+void Player_delete(Player* player) {
+	SDL_RWclose(player->file);
+	free(player->index);
+	free(player->buffer);
+	free(player);
+}
+
+static int apply_keyframe(CellsGrid* cells_grid, const Uint8* in, size_t size) {
+	size_t words = grid_words(cells_grid);
+	if (size == words * sizeof(CellsWord)) {
+		memcpy(cells_grid->cells, in, size);
+	}
+	else {
+		memset(cells_grid->cells, 0, words * sizeof(CellsWord));
+		if (Runs_decode_words(in, in + size, cells_grid->cells, words, 0) != in + size) {
+			return -1;
+		}
+	}
+
+	CellsGrid_touch(cells_grid, 0, 0, cells_grid->width, cells_grid->height);
+	return 0;
+}
+
+// Sets or clears cells [x0, x1) of a row
+static void fill_run(CellsWord* row, size_t x0, size_t x1, int is_alive) {
+	for (size_t i = x0 / CELLS_WORD_BITS; i <= (x1 - 1) / CELLS_WORD_BITS; ++i) {
+		size_t start = i == x0 / CELLS_WORD_BITS ? x0 % CELLS_WORD_BITS : 0;
+		size_t end = i == (x1 - 1) / CELLS_WORD_BITS ? (x1 - 1) % CELLS_WORD_BITS + 1 : CELLS_WORD_BITS;
+		CellsWord mask = (end == CELLS_WORD_BITS ? ~(CellsWord)0 : ((CellsWord)1 << end) - 1) & (~(CellsWord)0 << start);
+		row[i] = is_alive ? row[i] | mask : row[i] & ~mask;
+	}
+}
+
+// Changed cells are touched by tile rows, from the leftmost to the rightmost change in them
+static int apply_delta(CellsGrid* cells_grid, const Uint8* in, size_t size) {
+	const Uint8* end = in + size;
+	size_t next_row = 0;
+	size_t band = SIZE_MAX, band_x0 = 0, band_x1 = 0;
+
+	while (in < end) {
+		Uint64 gap;
+		in = Runs_get_varint(in, end, &gap);
+		if (in == NULL || gap >= cells_grid->height - next_row) {
+			return -1;
+		}
+		size_t y = next_row + gap;
+		next_row = y + 1;
+
+		if (y / CELLS_TILE_ROWS != band) {
+			if (band != SIZE_MAX && band_x1 > band_x0) {
+				CellsGrid_touch(cells_grid, band_x0, band * CELLS_TILE_ROWS, band_x1 - band_x0, CELLS_TILE_ROWS);
+			}
+			band = y / CELLS_TILE_ROWS;
+			band_x0 = SIZE_MAX;
+			band_x1 = 0;
+		}
+
+		CellsWord* row = CellsGrid_row(cells_grid, y);
+		for (int is_alive = 1; is_alive >= 0; --is_alive) {
+			size_t previous_end = 0;
+			for (;;) {
+				Uint64 length, run_gap;
+				in = Runs_get_varint(in, end, &length);
+				if (in == NULL) {
+					return -1;
+				}
+				if (length == 0) {
+					break;
+				}
+				in = Runs_get_varint(in, end, &run_gap);
+				if (in == NULL || run_gap > cells_grid->width - previous_end || length > cells_grid->width - previous_end - run_gap) {
+					return -1;
+				}
+
+				size_t x = previous_end + run_gap;
+				fill_run(row, x, x + length, is_alive);
+				previous_end = x + length;
+				band_x0 = SDL_min(band_x0, x);
+				band_x1 = SDL_max(band_x1, previous_end);
+			}
+		}
+	}
+
+	if (band != SIZE_MAX && band_x1 > band_x0) {
+		CellsGrid_touch(cells_grid, band_x0, band * CELLS_TILE_ROWS, band_x1 - band_x0, CELLS_TILE_ROWS);
+	}
+	return 0;
+}
+
+int Player_step(Player* player, CellsGrid* cells_grid) {
+	Sint64 offset = SDL_RWtell(player->file);
+	if (offset < 0 || (Uint64)offset >= player->data_end) {
+		return 0;
+	}
+
+	Uint8 kind;
+	Uint64 generation, size;
+	const Uint8* payload = NULL;
+	if (read_record_header(player, &kind, &generation, &size) == 0 && size <= player->data_end - offset - RECORD_HEADER_SIZE) {
+		payload = read_payload(player, size);
+	}
+
+	int result = -1;
+	if (payload != NULL && kind == RECORD_KEYFRAME) {
+		result = apply_keyframe(cells_grid, payload, size);
+	}
+	else if (payload != NULL && kind == RECORD_DELTA) {
+		result = apply_delta(cells_grid, payload, size);
+	}
+	if (result != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Recording is corrupted at offset %lld\n", (long long)offset);
+		return -1;
+	}
+
+	CellsGrid_set_generation(cells_grid, generation);
+	CellsGrid_update_heat(cells_grid);
+	return 1;
+}
+
+int Player_seek(Player* player, CellsGrid* cells_grid, Uint64 generation) {
+	// Latest keyframe whose records go through the generation
+	size_t keyframe = player->index_count;
+	for (size_t i = player->index_count; i-- > 0;) {
+		if (player->index[i].generation <= generation && generation <= player->index[i].last_generation) {
+			keyframe = i;
+			break;
+		}
+	}
+	if (keyframe == player->index_count || SDL_RWseek(player->file, player->index[keyframe].offset, RW_SEEK_SET) < 0) {
+		return -1;
+	}
+
+	while (Player_step(player, cells_grid) == 1) {
+		if (cells_grid->generation == generation) {
+			return 0;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,74 @@
+#include "../include/region.h"
+
+// A word of a packed row starting at any bit, even a negative one. Bits outside the row's words read as 0
+static inline CellsWord read_bits(const CellsWord* row, size_t words, long long bit) {
+	if (bit < 0) {
+		return bit <= -CELLS_WORD_BITS ? 0 : read_bits(row, words, 0) << -bit;
+	}
+
+	size_t i = bit / CELLS_WORD_BITS;
+	unsigned int shift = bit % CELLS_WORD_BITS;
+	CellsWord low = i < words ? row[i] >> shift : 0;
+	CellsWord high = shift != 0 && i + 1 < words ? row[i + 1] << (CELLS_WORD_BITS - shift) : 0;
+	return low | high;
+}
+
+// Moves width bits from source_x of the source row to destination_x of the destination, a destination word at a time
+static void blit_row(CellsWord* destination, size_t destination_x, const CellsWord* source, size_t source_words, size_t source_x, size_t width, int merge) {
+	size_t first = destination_x / CELLS_WORD_BITS, last = (destination_x + width - 1) / CELLS_WORD_BITS;
+	for (size_t i = first; i <= last; ++i) {
+		long long offset = (long long)(i * CELLS_WORD_BITS) - (long long)destination_x;
+		CellsWord bits = read_bits(source, source_words, (long long)source_x + offset);
+
+		unsigned int begin = i == first ? destination_x % CELLS_WORD_BITS : 0;
+		unsigned int end = i == last ? (destination_x + width - 1) % CELLS_WORD_BITS : CELLS_WORD_BITS - 1;
+		CellsWord mask = (~(CellsWord)0 >> (CELLS_WORD_BITS - 1 - end)) & (~(CellsWord)0 << begin);
+		destination[i] = merge ? destination[i] | (bits & mask) : (destination[i] & ~mask) | (bits & mask);
+	}
+}
+
+CellsRegion* CellsRegion_copy(const CellsGrid* cells_grid, size_t x, size_t y, size_t width, size_t height) {
+	if (x >= cells_grid->width || y >= cells_grid->height || width == 0 || height == 0) {
+		return NULL;
+	}
+
+	CellsRegion* region = calloc(1, sizeof(CellsRegion));
+	if (region == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells region\n");
+		return NULL;
+	}
+
+	region->width = SDL_min(width, cells_grid->width - x);
+	region->height = SDL_min(height, cells_grid->height - y);
+	region->words_per_row = (region->width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS;
+	region->cells = calloc(region->words_per_row * region->height, sizeof(CellsWord));
+	if (region->cells == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for %zux%zu cells region\n", region->width, region->height);
+		CellsRegion_delete(region);
+		return NULL;
+	}
+
+	for (size_t row = 0; row < region->height; ++row) {
+		blit_row(region->cells + row * region->words_per_row, 0, CellsGrid_row(cells_grid, y + row), cells_grid->words_per_row, x, region->width, 0);
+	}
+
+	return region;
+}
+
+void CellsRegion_delete(CellsRegion* region) {
+	free(region->cells);
+	free(region);
+}
+
+void CellsRegion_paste(const CellsRegion* region, CellsGrid* cells_grid, size_t x, size_t y, int merge) {
+	if (x >= cells_grid->width || y >= cells_grid->height) {
+		return;
+	}
+
+	size_t width = SDL_min(region->width, cells_grid->width - x), height = SDL_min(region->height, cells_grid->height - y);
+	for (size_t row = 0; row < height; ++row) {
+		blit_row(CellsGrid_row(cells_grid, y + row), x, region->cells + row * region->words_per_row, region->words_per_row, 0, width, merge);
+	}
+
+	CellsGrid_touch(cells_grid, x, y, width, height);
+}
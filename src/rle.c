@@ -0,0 +1,398 @@
+#include <ctype.h>
+#include "../include/rle.h"
+
+// Both reader and writer go through a buffer of this size, so I/O happens in big chunks
+#define RLE_BUFFER_SIZE (1 << 16)
+
+// Longest line of pattern data the format allows
+static const int RLE_LINE_LENGTH = 70;
+
+// Keeps run counts from overflowing on malformed input, far beyond any board side
+static const long long RLE_COUNT_MAX = 1ll << 40;
+
+typedef struct RleReaderStruct {
+	FILE* file;
+	size_t length, position;
+	char buffer[RLE_BUFFER_SIZE];
+} RleReader;
+
+static inline int read_char(RleReader* reader) {
+	if (reader->position == reader->length) {
+		reader->length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->file);
+		reader->position = 0;
+		if (reader->length == 0) {
+			return EOF;
+		}
+	}
+
+	return (unsigned char)reader->buffer[reader->position++];
+}
+
+// Reads a line into line (truncated to size), returns 0 at the end of file
+static int read_line(RleReader* reader, char* line, size_t size) {
+	size_t length = 0;
+	int c = read_char(reader);
+	if (c == EOF) {
+		return 0;
+	}
+
+	while (c != EOF && c != '\n') {
+		if (length + 1 < size) {
+			line[length++] = c;
+		}
+		c = read_char(reader);
+	}
+	line[length] = '\0';
+
+	return 1;
+}
+
+// Parses "x = 3, y = 3, rule = B3/S23", rule is optional
+static int parse_header(const char* line, long long* width, long long* height, Rule* rule, int* has_rule) {
+	*has_rule = 0;
+	int has_width = 0, has_height = 0;
+
+	while (*line != '\0') {
+		while (isspace((unsigned char)*line) || *line == ',') {
+			++line;
+		}
+		if (*line == '\0') {
+			break;
+		}
+
+		char key[16];
+		size_t key_length = 0;
+		while (isalpha((unsigned char)*line)) {
+			if (key_length + 1 < sizeof(key)) {
+				key[key_length++] = tolower((unsigned char)*line);
+			}
+			++line;
+		}
+		key[key_length] = '\0';
+
+		while (isspace((unsigned char)*line)) {
+			++line;
+		}
+		if (*line != '=') {
+			return -1;
+		}
+		++line;
+		while (isspace((unsigned char)*line)) {
+			++line;
+		}
+
+		char value[64];
+		size_t value_length = 0;
+		while (*line != '\0' && *line != ',' && !isspace((unsigned char)*line)) {
+			if (value_length + 1 < sizeof(value)) {
+				value[value_length++] = *line;
+			}
+			++line;
+		}
+		value[value_length] = '\0';
+
+		if (strcmp(key, "x") == 0) {
+			*width = strtoll(value, NULL, 10);
+			has_width = 1;
+		}
+		else if (strcmp(key, "y") == 0) {
+			*height = strtoll(value, NULL, 10);
+			has_height = 1;
+		}
+		else if (strcmp(key, "rule") == 0) {
+			// Bounded grid suffix like "B3/S23:T100,100" isn't supported, the board is always a torus
+			char* topology = strchr(value, ':');
+			if (topology != NULL) {
+				*topology = '\0';
+			}
+			if (Rule_parse(value, rule) != 0) {
+				return -1;
+			}
+			*has_rule = 1;
+		}
+	}
+
+	return has_width && has_height && *width >= 0 && *height >= 0 ? 0 : -1;
+}
+
+// Sets a run of alive cells [begin, end) in a row, both already clipped to the grid
+static inline void fill_run(CellsWord* row, long long begin, long long end) {
+	size_t first = begin / CELLS_WORD_BITS, last = (end - 1) / CELLS_WORD_BITS;
+	CellsWord first_mask = ~(CellsWord)0 << (begin % CELLS_WORD_BITS);
+	CellsWord last_mask = ~(CellsWord)0 >> (CELLS_WORD_BITS - 1 - (end - 1) % CELLS_WORD_BITS);
+
+	if (first == last) {
+		row[first] |= first_mask & last_mask;
+		return;
+	}
+
+	// Whole words in between are just filled
+	row[first] |= first_mask;
+	for (size_t i = first + 1; i < last; ++i) {
+		row[i] = ~(CellsWord)0;
+	}
+	row[last] |= last_mask;
+}
+
+int Rle_load(CellsGrid* cells_grid, const char* path, int centered, long long x, long long y) {
+	RleReader* reader = malloc(sizeof(RleReader));
+	if (reader == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for RLE reader\n");
+		return -1;
+	}
+	reader->length = reader->position = 0;
+	reader->file = fopen(path, "rb");
+	if (reader->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open pattern '%s'\n", path);
+		free(reader);
+		return -1;
+	}
+
+	// Comment lines ("#N name", "#C ...") come before the header
+	char line[256];
+	long long width = 0, height = 0;
+	Rule rule;
+	int has_rule = 0, has_header = 0;
+	while (read_line(reader, line, sizeof(line))) {
+		if (line[0] == '#' || line[0] == '\r' || line[0] == '\0') {
+			continue;
+		}
+
+		has_header = parse_header(line, &width, &height, &rule, &has_rule) == 0;
+		break;
+	}
+
+	if (!has_header) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pattern '%s' has no valid 'x = , y = ' header\n", path);
+		fclose(reader->file);
+		free(reader);
+		return -1;
+	}
+
+	if (centered) {
+		x = ((long long)cells_grid->width - width) / 2;
+		y = ((long long)cells_grid->height - height) / 2;
+	}
+	if (has_rule) {
+		cells_grid->rule = rule;
+	}
+
+	// Single pass over the runs straight from the read buffer, a count applies to the tag right after it.
+	// Columns are kept in grid coordinates and the row pointer is NULL while outside of the grid.
+	unsigned long long count = 0;
+	long long column = x, row = y;
+	CellsWord* row_cells = row >= 0 && row < (long long)cells_grid->height ? CellsGrid_row(cells_grid, row) : NULL;
+	int result = -1, in_comment = 0, done = 0;
+	while (!done) {
+		if (reader->position == reader->length) {
+			reader->length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->file);
+			reader->position = 0;
+			if (reader->length == 0) {
+				break;
+			}
+		}
+
+		const char* c = reader->buffer + reader->position;
+		const char* end = reader->buffer + reader->length;
+
+		// Comment lines are allowed between pattern lines too
+		if (in_comment) {
+			const char* newline = memchr(c, '\n', end - c);
+			in_comment = newline == NULL;
+			c = newline != NULL ? newline + 1 : end;
+		}
+
+		while (c < end) {
+			unsigned int tag = (unsigned char)*c++;
+
+			// Overflowing counts of malformed input wrap around harmlessly, they're clamped when used
+			unsigned int digit = tag - '0';
+			if (digit <= 9) {
+				count = count * 10 + digit;
+				continue;
+			}
+
+			long long run = count == 0 ? 1 : (long long)SDL_min(count, (unsigned long long)RLE_COUNT_MAX);
+			count = 0;
+
+			if (tag == 'b' || tag == '.') {
+				column += run;
+			}
+			else if (tag == '$') {
+				row += run;
+				column = x;
+				row_cells = row >= 0 && row < (long long)cells_grid->height ? CellsGrid_row(cells_grid, row) : NULL;
+			}
+			else if (isalpha(tag)) {
+				// "o" for two-state patterns, any other letter is an alive state of a multi-state one
+				if (row_cells != NULL) {
+					long long begin = SDL_max(column, 0), end_column = SDL_min(column + run, (long long)cells_grid->width);
+					if (begin < end_column) {
+						fill_run(row_cells, begin, end_column);
+					}
+				}
+				column += run;
+			}
+			else if (tag == '!') {
+				result = 0;
+				done = 1;
+				break;
+			}
+			else if (tag == '#') {
+				const char* newline = memchr(c, '\n', end - c);
+				in_comment = newline == NULL;
+				c = newline != NULL ? newline + 1 : end;
+			}
+			else if (!isspace(tag)) {
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unexpected '%c' in pattern '%s'\n", tag, path);
+				done = 1;
+				break;
+			}
+		}
+
+		reader->position = c - reader->buffer;
+	}
+
+	if (result != 0 && !done) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pattern '%s' has no terminating '!'\n", path);
+		result = 0;
+	}
+
+	fclose(reader->file);
+	free(reader);
+
+	// Step can skip tiles, the pattern area needs to be stepped again
+	long long x0 = SDL_max(x, 0), y0 = SDL_max(y, 0);
+	long long x1 = SDL_min(x + width, (long long)cells_grid->width), y1 = SDL_min(y + height, (long long)cells_grid->height);
+	if (x0 < x1 && y0 < y1) {
+		CellsGrid_touch(cells_grid, x0, y0, x1 - x0, y1 - y0);
+	}
+
+	return result;
+}
+
+typedef struct RleWriterStruct {
+	FILE* file;
+	size_t length;
+	int line_length;  // characters of pattern data on the current line
+	int failed;
+	char buffer[RLE_BUFFER_SIZE];
+} RleWriter;
+
+static void flush(RleWriter* writer) {
+	if (writer->length > 0 && fwrite(writer->buffer, 1, writer->length, writer->file) != writer->length) {
+		writer->failed = 1;
+	}
+	writer->length = 0;
+}
+
+static void write_text(RleWriter* writer, const char* text, size_t length) {
+	if (writer->length + length > sizeof(writer->buffer)) {
+		flush(writer);
+	}
+	memcpy(writer->buffer + writer->length, text, length);
+	writer->length += length;
+}
+
+// Writes "<count><tag>", wrapping lines before they get too long
+static void write_run(RleWriter* writer, unsigned long long count, char tag) {
+	if (count == 0) {
+		return;
+	}
+
+	// Digits are produced backwards from the end of the buffer, printf is far too slow for this
+	char run[24];
+	char* digits = run + sizeof(run);
+	*--digits = tag;
+	if (count > 1) {
+		for (; count > 0; count /= 10) {
+			*--digits = '0' + count % 10;
+		}
+	}
+	int length = run + sizeof(run) - digits;
+
+	if (writer->line_length + length > RLE_LINE_LENGTH) {
+		write_text(writer, "\n", 1);
+		writer->line_length = 0;
+	}
+	write_text(writer, digits, length);
+	writer->line_length += length;
+}
+
+// Length of the run of cells in the same state starting at x, found a word at a time
+static size_t run_length(const CellsWord* row, size_t x, size_t width, int is_alive) {
+	size_t start = x;
+	while (x < width) {
+		unsigned int bit = x % CELLS_WORD_BITS;
+		CellsWord word = row[x / CELLS_WORD_BITS];
+		CellsWord others = (is_alive ? ~word : word) >> bit;  // cells in the other state, from x onwards
+
+		if (others != 0) {
+			x += __builtin_ctzll(others);
+			break;
+		}
+		x += CELLS_WORD_BITS - bit;
+	}
+
+	return SDL_min(x, width) - start;
+}
+
+int Rle_save(const CellsGrid* cells_grid, const char* path) {
+	RleWriter* writer = malloc(sizeof(RleWriter));
+	if (writer == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for RLE writer\n");
+		return -1;
+	}
+	writer->length = 0;
+	writer->line_length = 0;
+	writer->failed = 0;
+	writer->file = fopen(path, "wb");
+	if (writer->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' for writing\n", path);
+		free(writer);
+		return -1;
+	}
+
+	char header[128], rule[32];
+	Rule_format(cells_grid->rule, rule, sizeof(rule));
+	int header_length = snprintf(header, sizeof(header), "x = %zu, y = %zu, rule = %s\n", cells_grid->width, cells_grid->height, rule);
+	write_text(writer, header, header_length);
+
+	// Empty rows are collected and written as a single "<n>$" before the next row with alive cells
+	unsigned long long pending_rows = 0;
+	for (size_t y = 0; y < cells_grid->height; ++y) {
+		const CellsWord* row = CellsGrid_row(cells_grid, y);
+
+		size_t x = 0;
+		while (x < cells_grid->width) {
+			size_t dead = run_length(row, x, cells_grid->width, 0);
+			if (x + dead == cells_grid->width) {
+				break;
+			}
+
+			if (pending_rows > 0) {
+				write_run(writer, pending_rows, '$');
+				pending_rows = 0;
+			}
+
+			size_t alive = run_length(row, x + dead, cells_grid->width, 1);
+			write_run(writer, dead, 'b');
+			write_run(writer, alive, 'o');
+			x += dead + alive;
+		}
+
+		++pending_rows;
+	}
+	write_text(writer, "!\n", 2);
+
+	flush(writer);
+	int failed = fclose(writer->file) != 0 || writer->failed;
+	free(writer);
+
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write pattern '%s'\n", path);
+		return -1;
+	}
+
+	return 0;
+}
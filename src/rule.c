@@ -0,0 +1,68 @@
+#include <ctype.h>
+#include "../include/rule.h"
+
+// Reads neighbour counts until a character that isn't a digit, returns pointer past them
+static const char* parse_counts(const char* text, Uint16* mask) {
+	*mask = 0;
+	while (*text >= '0' && *text <= '8') {
+		*mask |= 1 << (*text - '0');
+		++text;
+	}
+
+	return text;
+}
+
+int Rule_parse(const char* text, Rule* rule) {
+	Rule result;
+
+	while (isspace((unsigned char)*text)) {
+		++text;
+	}
+
+	if (toupper((unsigned char)*text) == 'B') {
+		text = parse_counts(text + 1, &result.birth);
+		if (*text != '/' || toupper((unsigned char)text[1]) != 'S') {
+			return -1;
+		}
+		text = parse_counts(text + 2, &result.survival);
+	}
+	else {
+		text = parse_counts(text, &result.survival);
+		if (*text != '/') {
+			return -1;
+		}
+		text = parse_counts(text + 1, &result.birth);
+	}
+
+	while (isspace((unsigned char)*text)) {
+		++text;
+	}
+	if (*text != '\0') {
+		return -1;
+	}
+
+	*rule = result;
+	return 0;
+}
+
+void Rule_format(Rule rule, char* buffer, size_t size) {
+	char text[24];
+	size_t length = 0;
+
+	text[length++] = 'B';
+	for (int n = 0; n <= 8; ++n) {
+		if (rule.birth & (1 << n)) {
+			text[length++] = '0' + n;
+		}
+	}
+	text[length++] = '/';
+	text[length++] = 'S';
+	for (int n = 0; n <= 8; ++n) {
+		if (rule.survival & (1 << n)) {
+			text[length++] = '0' + n;
+		}
+	}
+	text[length] = '\0';
+
+	SDL_strlcpy(buffer, text, size);
+}
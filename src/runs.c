@@ -0,0 +1,146 @@
+#include "../include/runs.h"
+
+// Byte runs shorter than this are cheaper to keep in a literal
+static const size_t RUNS_MIN_BYTE_RUN = 4;
+
+size_t Runs_put_varint(Uint8* out, Uint64 value) {
+	size_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	out[length++] = value;
+	return length;
+}
+
+const Uint8* Runs_get_varint(const Uint8* in, const Uint8* end, Uint64* value) {
+	*value = 0;
+	for (unsigned int shift = 0; in < end && shift < 64; shift += 7) {
+		Uint8 byte = *in++;
+		*value |= (Uint64)(byte & 0x7f) << shift;
+		if (byte < 0x80) {
+			return in;
+		}
+	}
+
+	return NULL;
+}
+
+size_t Runs_encode_words(const Uint64* words, size_t count, Uint8* out, size_t capacity) {
+	size_t length = 0;
+	for (size_t i = 0; i < count;) {
+		size_t begin = i;
+		int empty = words[i] == 0;
+		while (i < count && (words[i] == 0) == empty) {
+			++i;
+		}
+
+		size_t data = empty ? 0 : (i - begin) * sizeof(Uint64);
+		if (length + 10 + data > capacity) {
+			return 0;
+		}
+
+		length += Runs_put_varint(out + length, (Uint64)(i - begin) << 1 | empty);
+		memcpy(out + length, words + begin, data);
+		length += data;
+	}
+
+	return length;
+}
+
+const Uint8* Runs_decode_words(const Uint8* in, const Uint8* end, Uint64* words, size_t count, int xor) {
+	size_t i = 0;
+	while (i < count) {
+		Uint64 token;
+		in = Runs_get_varint(in, end, &token);
+		if (in == NULL || (token >> 1) > count - i) {
+			return NULL;
+		}
+
+		size_t run = token >> 1;
+		if (!(token & 1)) {
+			if (run * sizeof(Uint64) > (size_t)(end - in)) {
+				return NULL;
+			}
+			if (xor) {
+				for (size_t j = 0; j < run; ++j) {
+					Uint64 word;
+					memcpy(&word, in + j * sizeof(Uint64), sizeof(word));
+					words[i + j] ^= word;
+				}
+			}
+			else {
+				memcpy(words + i, in, run * sizeof(Uint64));
+			}
+			in += run * sizeof(Uint64);
+		}
+		i += run;
+	}
+
+	return in;
+}
+
+static inline size_t byte_run(const Uint8* bytes, size_t i, size_t count) {
+	size_t j = i + 1;
+	while (j < count && bytes[j] == bytes[i]) {
+		++j;
+	}
+	return j - i;
+}
+
+size_t Runs_encode_bytes(const Uint8* bytes, size_t count, Uint8* out, size_t capacity) {
+	size_t length = 0;
+	for (size_t i = 0; i < count;) {
+		size_t run = byte_run(bytes, i, count);
+		if (run >= RUNS_MIN_BYTE_RUN) {
+			if (length + 11 > capacity) {
+				return 0;
+			}
+			length += Runs_put_varint(out + length, (Uint64)run << 1 | 1);
+			out[length++] = bytes[i];
+			i += run;
+			continue;
+		}
+
+		// Literal up to the next run worth coding
+		size_t begin = i;
+		while (i < count && run < RUNS_MIN_BYTE_RUN) {
+			i += run;
+			run = i < count ? byte_run(bytes, i, count) : 0;
+		}
+		if (length + 10 + (i - begin) > capacity) {
+			return 0;
+		}
+		length += Runs_put_varint(out + length, (Uint64)(i - begin) << 1);
+		memcpy(out + length, bytes + begin, i - begin);
+		length += i - begin;
+	}
+
+	return length;
+}
+
+const Uint8* Runs_decode_bytes(const Uint8* in, const Uint8* end, Uint8* bytes, size_t count) {
+	size_t i = 0;
+	while (i < count) {
+		Uint64 token;
+		in = Runs_get_varint(in, end, &token);
+		if (in == NULL || (token >> 1) > count - i || in == end) {
+			return NULL;
+		}
+
+		size_t run = token >> 1;
+		if (token & 1) {
+			memset(bytes + i, *in++, run);
+		}
+		else {
+			if (run > (size_t)(end - in)) {
+				return NULL;
+			}
+			memcpy(bytes + i, in, run);
+			in += run;
+		}
+		i += run;
+	}
+
+	return in;
+}
@@ -0,0 +1,488 @@
+#include "../include/screenshot.h"
+#include "../include/utils.h"
+
+static const Uint8 PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+// Zlib header, stored block header, payload and Adler-32 of an IDAT chunk's data
+enum {
+	BLOCK_ZLIB_HEADER = 2,
+	BLOCK_HEADER = 5,
+	BLOCK_PAYLOAD = BLOCK_ZLIB_HEADER + BLOCK_HEADER,
+	BLOCK_ADLER = 4
+};
+
+// Adler-32 sums can be left unreduced for this many bytes without overflowing
+static const size_t ADLER_RUN = 5552;
+
+// Bytes of pixels a strip is sized for, every thread rasterises one strip at a time
+static const size_t STRIP_SIZE = (size_t)1 << 20;
+
+static inline void put_be32(Uint8* out, Uint32 value) {
+	out[0] = value >> 24;
+	out[1] = value >> 16;
+	out[2] = value >> 8;
+	out[3] = value;
+}
+
+static inline void put_le32(Uint8* out, Uint32 value) {
+	out[0] = value;
+	out[1] = value >> 8;
+	out[2] = value >> 16;
+	out[3] = value >> 24;
+}
+
+// CRC-32 of PNG chunks, the table is built on the first call
+static Uint32 crc32_update(Uint32 crc, const Uint8* data, size_t size) {
+	static Uint32 table[256];
+	static int table_built = 0;
+	if (!table_built) {
+		for (Uint32 i = 0; i < 256; ++i) {
+			Uint32 value = i;
+			for (int bit = 0; bit < 8; ++bit) {
+				value = value & 1 ? 0xedb88320 ^ (value >> 1) : value >> 1;
+			}
+			table[i] = value;
+		}
+		table_built = 1;
+	}
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void adler32_update(ImageWriter* writer, const Uint8* data, size_t size) {
+	Uint32 a = writer->adler_a, b = writer->adler_b;
+	while (size > 0) {
+		size_t run = SDL_min(size, ADLER_RUN);
+		for (size_t i = 0; i < run; ++i) {
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		data += run;
+		size -= run;
+	}
+	writer->adler_a = a;
+	writer->adler_b = b;
+}
+
+static void write_bytes(ImageWriter* writer, const void* data, size_t size) {
+	if (!writer->failed && fwrite(data, 1, size, writer->file) != size) {
+		writer->failed = 1;
+	}
+}
+
+static void write_chunk(ImageWriter* writer, const char* type, const Uint8* data, size_t size) {
+	Uint8 header[8], crc[4];
+	put_be32(header, size);
+	memcpy(header + 4, type, 4);
+	put_be32(crc, crc32_update(crc32_update(0, header + 4, 4), data, size));
+
+	write_bytes(writer, header, sizeof(header));
+	if (size > 0) {
+		write_bytes(writer, data, size);
+	}
+	write_bytes(writer, crc, sizeof(crc));
+}
+
+// Every stored block goes out as an IDAT chunk of its own, the first one carrying the zlib header and the
+// last one the checksum. The size of the whole payload is known up front, so the last block is known too
+static void flush_block(ImageWriter* writer) {
+	int is_last = writer->data_left == 0;
+	Uint8* block = writer->block;
+	size_t start = BLOCK_ZLIB_HEADER, end = BLOCK_PAYLOAD + writer->block_filled;
+	if (writer->block_first) {
+		block[0] = 0x78;  // deflate with a 32 KB window
+		block[1] = 0x01;  // no dictionary, fastest level, header is a multiple of 31
+		start = 0;
+		writer->block_first = 0;
+	}
+
+	Uint8* header = block + BLOCK_ZLIB_HEADER;
+	header[0] = is_last;  // stored block, final bit set on the last one
+	header[1] = writer->block_filled;
+	header[2] = writer->block_filled >> 8;
+	header[3] = ~writer->block_filled;
+	header[4] = ~writer->block_filled >> 8;
+	if (is_last) {
+		put_be32(block + end, writer->adler_b << 16 | writer->adler_a);
+		end += BLOCK_ADLER;
+	}
+
+	write_chunk(writer, "IDAT", block + start, end - start);
+	writer->block_filled = 0;
+}
+
+static void put_payload(ImageWriter* writer, const Uint8* data, size_t size) {
+	adler32_update(writer, data, size);
+	while (size > 0) {
+		size_t count = SDL_min(size, (size_t)IMAGE_BLOCK_SIZE - writer->block_filled);
+		memcpy(writer->block + BLOCK_PAYLOAD + writer->block_filled, data, count);
+		writer->block_filled += count;
+		writer->data_left -= count;
+		data += count;
+		size -= count;
+
+		if (writer->block_filled == IMAGE_BLOCK_SIZE || writer->data_left == 0) {
+			flush_block(writer);
+		}
+	}
+}
+
+static void write_png_header(ImageWriter* writer, const SDL_Color* palette) {
+	write_bytes(writer, PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+
+	Uint8 header[13];
+	put_be32(header, writer->width);
+	put_be32(header + 4, writer->height);
+	header[8] = palette != NULL ? 1 : 8;  // bit depth
+	header[9] = palette != NULL ? 3 : 2;  // indexed or RGB
+	header[10] = 0;  // deflate
+	header[11] = 0;  // adaptive filtering, every row uses none
+	header[12] = 0;  // not interlaced
+	write_chunk(writer, "IHDR", header, sizeof(header));
+
+	if (palette != NULL) {
+		Uint8 colors[6] = {palette[0].r, palette[0].g, palette[0].b, palette[1].r, palette[1].g, palette[1].b};
+		write_chunk(writer, "PLTE", colors, sizeof(colors));
+	}
+}
+
+static void write_bmp_header(ImageWriter* writer, size_t padded_size, const SDL_Color* palette) {
+	Uint32 offset = 14 + 40 + (palette != NULL ? 2 * 4 : 0);
+	Uint32 image_size = padded_size * writer->height;
+
+	Uint8 header[14 + 40 + 2 * 4] = {'B', 'M'};
+	put_le32(header + 2, offset + image_size);
+	put_le32(header + 10, offset);
+	put_le32(header + 14, 40);
+	put_le32(header + 18, writer->width);
+	put_le32(header + 22, -(Sint32)writer->height);  // rows go top to bottom
+	header[26] = 1;  // planes
+	header[28] = writer->bits_per_pixel;
+	put_le32(header + 34, image_size);
+	put_le32(header + 38, 2835);  // 72 DPI
+	put_le32(header + 42, 2835);
+	if (palette != NULL) {
+		put_le32(header + 46, 2);
+		for (int i = 0; i < 2; ++i) {
+			Uint8* entry = header + 54 + i * 4;
+			entry[0] = palette[i].b;
+			entry[1] = palette[i].g;
+			entry[2] = palette[i].r;
+		}
+	}
+	write_bytes(writer, header, offset);
+}
+
+ImageWriter* ImageWriter_open(const char* path, size_t width, size_t height, const SDL_Color* palette) {
+	int is_bmp = has_extension(path, ".bmp");
+	int bits_per_pixel = palette != NULL ? 1 : 24;
+	size_t row_size = (width * bits_per_pixel + 7) / 8;
+	size_t padded_size = (row_size + 3) / 4 * 4;
+
+	// Both formats keep dimensions in 31 bits, BMP keeps the file size in 32
+	if (width == 0 || height == 0 || width > SDL_MAX_SINT32 || height > SDL_MAX_SINT32 ||
+		(is_bmp && (Uint64)padded_size * height > SDL_MAX_UINT32 - 62)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Image of %zux%zu pixels is too big for '%s'\n", width, height, path);
+		return NULL;
+	}
+
+	ImageWriter* writer = calloc(1, sizeof(ImageWriter));
+	if (writer == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for image writer\n");
+		return NULL;
+	}
+	writer->is_bmp = is_bmp;
+	writer->width = width;
+	writer->height = height;
+	writer->bits_per_pixel = bits_per_pixel;
+	writer->row_size = row_size;
+	SDL_strlcpy(writer->path, path, sizeof(writer->path));
+
+	if (is_bmp) {
+		writer->row = calloc(padded_size, 1);
+	}
+	else {
+		writer->block = malloc(BLOCK_PAYLOAD + IMAGE_BLOCK_SIZE + BLOCK_ADLER);
+		writer->data_left = (Uint64)(row_size + 1) * height;
+		writer->adler_a = 1;
+		writer->block_first = 1;
+	}
+	if (writer->row == NULL && writer->block == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for image rows\n");
+		free(writer);
+		return NULL;
+	}
+
+	writer->file = fopen(path, "wb");
+	if (writer->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open image '%s'\n", path);
+		free(writer->row);
+		free(writer->block);
+		free(writer);
+		return NULL;
+	}
+
+	if (is_bmp) {
+		write_bmp_header(writer, padded_size, palette);
+	}
+	else {
+		write_png_header(writer, palette);
+	}
+
+	return writer;
+}
+
+int ImageWriter_write_row(ImageWriter* writer, const Uint8* row) {
+	if (writer->rows_written == writer->height) {
+		writer->failed = 1;
+		return -1;
+	}
+	++writer->rows_written;
+
+	if (writer->is_bmp) {
+		if (writer->bits_per_pixel == 24) {
+			for (size_t i = 0; i < writer->row_size; i += 3) {
+				writer->row[i] = row[i + 2];
+				writer->row[i + 1] = row[i + 1];
+				writer->row[i + 2] = row[i];
+			}
+		}
+		else {
+			memcpy(writer->row, row, writer->row_size);
+		}
+		write_bytes(writer, writer->row, (writer->row_size + 3) / 4 * 4);
+	}
+	else {
+		const Uint8 filter = 0;
+		put_payload(writer, &filter, 1);
+		put_payload(writer, row, writer->row_size);
+	}
+
+	return writer->failed ? -1 : 0;
+}
+
+int ImageWriter_close(ImageWriter* writer) {
+	int failed = writer->failed || writer->rows_written != writer->height;
+	if (!failed && !writer->is_bmp) {
+		write_chunk(writer, "IEND", NULL, 0);
+		failed = writer->failed;
+	}
+	if (fclose(writer->file) != 0) {
+		failed = 1;
+	}
+
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write image '%s'\n", writer->path);
+		remove(writer->path);
+	}
+	free(writer->row);
+	free(writer->block);
+	free(writer);
+
+	return failed ? -1 : 0;
+}
+
+typedef struct ScreenshotJobStruct ScreenshotJob;
+
+// Pixels of a strip of cell rows, handed between a rasterising thread and the writing one
+typedef struct StripStruct {
+	ScreenshotJob* job;
+	SDL_Thread* thread;
+	SDL_sem* free;
+	SDL_sem* ready;
+	Uint8* pixels;
+} Strip;
+
+struct ScreenshotJobStruct {
+	const CellsGrid* cells_grid;
+	SDL_Color palette[2][CELL_AGE_MAX + 1];  // [alive][age]
+	int indexed;  // ages aren't tracked, so a cell is just its bit
+	unsigned int scale;
+	size_t row_size;
+	size_t strip_rows;  // of cells
+	size_t strip_count;
+	int thread_count;
+	Strip* strips;
+	SDL_atomic_t quit;
+};
+
+// Swaps every byte's bits around, cells are kept from the lowest bit up but image rows are packed from the highest
+static inline CellsWord reverse_bits(CellsWord word) {
+	word = (word & 0x5555555555555555) << 1 | ((word >> 1) & 0x5555555555555555);
+	word = (word & 0x3333333333333333) << 2 | ((word >> 2) & 0x3333333333333333);
+	return (word & 0x0f0f0f0f0f0f0f0f) << 4 | ((word >> 4) & 0x0f0f0f0f0f0f0f0f);
+}
+
+static void rasterise_row_bits(const ScreenshotJob* job, size_t y, Uint8* out) {
+	const CellsGrid* cells_grid = job->cells_grid;
+	const CellsWord* row = CellsGrid_row(cells_grid, y);
+
+	if (job->scale == 1) {
+		for (size_t i = 0, byte = 0; i < cells_grid->words_per_row; ++i) {
+			CellsWord word = reverse_bits(row[i]);
+			for (int j = 0; j < 8 && byte < job->row_size; ++j, ++byte, word >>= 8) {
+				out[byte] = word;
+			}
+		}
+		return;
+	}
+
+	memset(out, 0, job->row_size);
+	for (size_t i = 0; i < cells_grid->words_per_row; ++i) {
+		for (CellsWord word = row[i]; word != 0; word &= word - 1) {
+			size_t x = (i * CELLS_WORD_BITS + __builtin_ctzll(word)) * job->scale;
+			for (unsigned int j = 0; j < job->scale; ++j, ++x) {
+				out[x / 8] |= 0x80 >> (x % 8);
+			}
+		}
+	}
+}
+
+// Looks up colors the way CellsGrid_get_age ages cells, a whole word of them at a time
+static void rasterise_row_rgb(const ScreenshotJob* job, size_t y, Uint8* out) {
+	const CellsGrid* cells_grid = job->cells_grid;
+	const CellsWord* row = CellsGrid_row(cells_grid, y);
+	const Uint8* ages = cells_grid->age + y * cells_grid->width;
+
+	for (size_t i = 0; i < cells_grid->words_per_row; ++i) {
+		CellsWord word = row[i];
+		Uint64 behind = cells_grid->generation - cells_grid->age_generation[CellsGrid_tile_index(cells_grid, i * CELLS_WORD_BITS, y)];
+		size_t x0 = i * CELLS_WORD_BITS, x1 = SDL_min(x0 + CELLS_WORD_BITS, cells_grid->width);
+		for (size_t x = x0; x < x1; ++x, word >>= 1) {
+			Uint64 age = ages[x] + behind;
+			SDL_Color color = job->palette[word & 1][age < CELL_AGE_MAX ? age : CELL_AGE_MAX];
+			for (unsigned int j = 0; j < job->scale; ++j, out += 3) {
+				out[0] = color.r;
+				out[1] = color.g;
+				out[2] = color.b;
+			}
+		}
+	}
+}
+
+// Every thread takes every thread_count-th strip, waiting for the writer to be done with its buffer first
+static int rasterise_strips(void* data) {
+	Strip* strip = data;
+	ScreenshotJob* job = strip->job;
+	const CellsGrid* cells_grid = job->cells_grid;
+
+	for (size_t index = strip - job->strips; index < job->strip_count; index += job->thread_count) {
+		SDL_SemWait(strip->free);
+		if (SDL_AtomicGet(&job->quit)) {
+			break;
+		}
+
+		size_t y0 = index * job->strip_rows, y1 = SDL_min(y0 + job->strip_rows, cells_grid->height);
+		Uint8* out = strip->pixels;
+		for (size_t y = y0; y < y1; ++y) {
+			if (job->indexed) {
+				rasterise_row_bits(job, y, out);
+			}
+			else {
+				rasterise_row_rgb(job, y, out);
+			}
+			for (unsigned int i = 1; i < job->scale; ++i) {
+				memcpy(out + i * job->row_size, out, job->row_size);
+			}
+			out += job->scale * job->row_size;
+		}
+		SDL_SemPost(strip->ready);
+	}
+
+	return 0;
+}
+
+static void delete_strips(ScreenshotJob* job) {
+	for (int i = 0; i < job->thread_count; ++i) {
+		Strip* strip = &job->strips[i];
+		if (strip->free != NULL) {
+			SDL_DestroySemaphore(strip->free);
+		}
+		if (strip->ready != NULL) {
+			SDL_DestroySemaphore(strip->ready);
+		}
+		free(strip->pixels);
+	}
+	free(job->strips);
+}
+
+int Screenshot_save(const CellsGrid* cells_grid, const Gradient* gradient, const char* path) {
+	ScreenshotJob job = {.cells_grid = cells_grid, .indexed = cells_grid->age == NULL, .scale = cells_grid->cell_size};
+	for (int is_alive = 0; is_alive <= 1; ++is_alive) {
+		for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+			job.palette[is_alive][age] = Gradient_color(gradient, is_alive, age);
+		}
+	}
+
+	SDL_Color palette[2] = {job.palette[0][CELL_AGE_MAX], job.palette[1][CELL_AGE_MAX]};
+	ImageWriter* writer = ImageWriter_open(path, cells_grid->width * job.scale, cells_grid->height * job.scale, job.indexed ? palette : NULL);
+	if (writer == NULL) {
+		return -1;
+	}
+	job.row_size = writer->row_size;
+
+	// Strips are kept around a megabyte, rows of a very wide board each make a strip of their own
+	size_t cell_row_size = job.row_size * job.scale;
+	job.strip_rows = SDL_max((size_t)1, STRIP_SIZE / cell_row_size);
+	job.strip_count = (cells_grid->height + job.strip_rows - 1) / job.strip_rows;
+	job.thread_count = SDL_min((size_t)SDL_max(SDL_GetCPUCount(), 1), job.strip_count);
+
+	job.strips = calloc(job.thread_count, sizeof(Strip));
+	int failed = job.strips == NULL;
+	for (int i = 0; i < job.thread_count && !failed; ++i) {
+		Strip* strip = &job.strips[i];
+		strip->job = &job;
+		strip->free = SDL_CreateSemaphore(1);
+		strip->ready = SDL_CreateSemaphore(0);
+		strip->pixels = malloc(job.strip_rows * cell_row_size);
+		failed = strip->free == NULL || strip->ready == NULL || strip->pixels == NULL;
+	}
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for screenshot strips\n");
+		if (job.strips != NULL) {
+			delete_strips(&job);
+		}
+		writer->failed = 1;
+		ImageWriter_close(writer);
+		return -1;
+	}
+
+	int started = 0;
+	for (; started < job.thread_count; ++started) {
+		job.strips[started].thread = SDL_CreateThread(rasterise_strips, "screenshot", &job.strips[started]);
+		if (job.strips[started].thread == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start screenshot threads: %s\n", SDL_GetError());
+			failed = 1;
+			break;
+		}
+	}
+
+	// Strips are written in order as they're ready, then their buffers go back to the threads
+	for (size_t index = 0; index < job.strip_count && !failed; ++index) {
+		Strip* strip = &job.strips[index % job.thread_count];
+		SDL_SemWait(strip->ready);
+
+		size_t rows = (SDL_min((index + 1) * job.strip_rows, cells_grid->height) - index * job.strip_rows) * job.scale;
+		for (size_t i = 0; i < rows && !failed; ++i) {
+			failed = ImageWriter_write_row(writer, strip->pixels + i * job.row_size) != 0;
+		}
+		SDL_SemPost(strip->free);
+	}
+
+	// Threads left waiting for a buffer wake up to quit
+	SDL_AtomicSet(&job.quit, 1);
+	for (int i = 0; i < started; ++i) {
+		SDL_SemPost(job.strips[i].free);
+		SDL_WaitThread(job.strips[i].thread, NULL);
+	}
+	delete_strips(&job);
+
+	writer->failed |= failed;
+	return ImageWriter_close(writer);
+}
@@ -0,0 +1,352 @@
+#include "../include/simulation.h"
+
+// Set in latest while the snapshot it points to hasn't been taken by the reader
+#define SIMULATION_FRESH 4
+
+// When stepping can't keep up with the rate, generations owed past this fraction of a second are dropped
+static const Uint64 SIMULATION_BACKLOG_DIVISOR = 4;
+
+// A run of steps holds commands up for at most this fraction of a second
+static const Uint64 SIMULATION_BATCH_DIVISOR = 100;
+
+// Bytes CellsGrid_create_snapshot allocates for the grid
+static size_t snapshot_size(const CellsGrid* cells_grid) {
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	size_t size = sizeof(CellsWord) * cells_grid->words_per_row * cells_grid->height + (sizeof(Uint64) + sizeof(Uint16)) * tiles;
+	if (cells_grid->age != NULL) {
+		size += cells_grid->width * cells_grid->height + sizeof(Uint64) * tiles;
+	}
+	return size;
+}
+
+// Generations skipped by seeking through a recording are relative to the live grid, not a snapshot
+static void seek(Simulation* simulation, Sint64 generations) {
+	Uint64 generation = simulation->cells_grid->generation;
+	Uint64 target = generations < 0 ? generation - SDL_min(generation, (Uint64)-generations) : generation + generations;
+	Player_seek(simulation->player, simulation->cells_grid, target);
+}
+
+// Replaces the clipboard with the rectangle between the command's corners, returns 0 if anything was copied
+static int copy(Simulation* simulation, const SimulationCommand* command) {
+	size_t x = SDL_min(command->from_x, command->x), y = SDL_min(command->from_y, command->y);
+	size_t width = SDL_max(command->from_x, command->x) - x + 1, height = SDL_max(command->from_y, command->y) - y + 1;
+
+	if (simulation->clipboard != NULL) {
+		CellsRegion_delete(simulation->clipboard);
+	}
+	simulation->clipboard = CellsRegion_copy(simulation->cells_grid, x, y, width, height);
+	return simulation->clipboard != NULL ? 0 : -1;
+}
+
+static void run(Simulation* simulation, const SimulationCommand* command) {
+	CellsGrid* cells_grid = simulation->cells_grid;
+
+	switch (command->type) {
+		case SIMULATION_PAINT:
+			if (command->x < cells_grid->width && command->y < cells_grid->height &&
+				command->from_x < cells_grid->width && command->from_y < cells_grid->height) {
+				CellsGrid_paint(cells_grid, command->from_x, command->from_y, command->x, command->y, command->radius, command->value != 0);
+			}
+			break;
+		case SIMULATION_RANDOMIZE:
+			CellsGrid_randomize(cells_grid);
+			break;
+		case SIMULATION_CLEAR:
+			CellsGrid_clear(cells_grid);
+			break;
+		case SIMULATION_TOGGLE_PAUSE:
+			simulation->pause = !simulation->pause;
+			break;
+		case SIMULATION_SET_RATE:
+			simulation->rate = command->value;
+			simulation->accumulator = 0;
+			break;
+		case SIMULATION_REWIND:
+			if (simulation->player != NULL) {
+				seek(simulation, -1);
+				simulation->pause = 1;
+			}
+			else if (simulation->history != NULL) {
+				History_record(simulation->history, cells_grid);
+				History_rewind(simulation->history, cells_grid, 1);
+				simulation->pause = 1;
+			}
+			break;
+		case SIMULATION_SEEK:
+			if (simulation->player != NULL) {
+				seek(simulation, command->value);
+			}
+			break;
+		case SIMULATION_SET_HEAT:
+			CellsGrid_set_heat_tracking(cells_grid, command->value != 0);
+			break;
+		case SIMULATION_COPY:
+			copy(simulation, command);
+			break;
+		case SIMULATION_CUT:
+			if (copy(simulation, command) == 0) {
+				CellsGrid_fill(cells_grid, SDL_min(command->from_x, command->x), SDL_min(command->from_y, command->y),
+							   simulation->clipboard->width, simulation->clipboard->height, 0);
+			}
+			break;
+		case SIMULATION_PASTE:
+			if (simulation->clipboard != NULL) {
+				CellsRegion_paste(simulation->clipboard, cells_grid, command->x, command->y, command->value != 0);
+			}
+			break;
+	}
+}
+
+// Fills the back snapshot and swaps it with the latest one. Returns -1 if the only snapshot is locked by the reader
+static int publish(Simulation* simulation) {
+	if (simulation->lock != NULL && SDL_TryLockMutex(simulation->lock) != 0) {
+		return -1;
+	}
+
+	CellsGrid_update_snapshot(simulation->snapshots[simulation->back], simulation->cells_grid);
+	simulation->stats[simulation->back] = simulation->totals;
+	if (simulation->lock != NULL) {
+		SDL_AtomicSet(&simulation->latest, SIMULATION_FRESH);
+		SDL_UnlockMutex(simulation->lock);
+	}
+	else {
+		SDL_MemoryBarrierRelease();
+		simulation->back = SDL_AtomicSet(&simulation->latest, simulation->back | SIMULATION_FRESH) & ~SIMULATION_FRESH;
+	}
+
+	if (SDL_AtomicCAS(&simulation->waiting, 1, 0) && simulation->wake_event != (Uint32)-1) {
+		SDL_Event event;
+		memset(&event, 0, sizeof(event));
+		event.type = simulation->wake_event;
+		SDL_PushEvent(&event);
+	}
+
+	return 0;
+}
+
+static int simulate(void* data) {
+	Simulation* simulation = data;
+	CellsGrid* cells_grid = simulation->cells_grid;
+
+	while (!SDL_AtomicGet(&simulation->quit)) {
+		int tail = SDL_AtomicGet(&simulation->tail), head = SDL_AtomicGet(&simulation->head);
+		SDL_MemoryBarrierAcquire();
+		int changed = tail != head;
+
+		// Steps are only recorded every few generations, so the state edits start from is recorded first for
+		// them to be undone exactly
+		if (changed && simulation->history != NULL) {
+			History_record(simulation->history, cells_grid);
+		}
+		for (; tail != head; tail = (tail + 1) % SIMULATION_QUEUE_LENGTH) {
+			run(simulation, &simulation->commands[tail]);
+		}
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicSet(&simulation->tail, tail);
+
+		// Edits and steps get separate history entries, so either can be undone
+		if (changed && simulation->history != NULL) {
+			History_record(simulation->history, cells_grid);
+		}
+
+		// Time since the last loop is counted in counter ticks times the rate and a generation is due every
+		// frequency of them, so the rate is kept exactly without rounding building up
+		Uint64 frequency = SDL_GetPerformanceFrequency(), time = SDL_GetPerformanceCounter();
+		if (!simulation->pause && simulation->rate != 0) {
+			Uint64 backlog = frequency * SDL_max(1, simulation->rate / SIMULATION_BACKLOG_DIVISOR);
+			simulation->accumulator = SDL_min(simulation->accumulator + (time - simulation->last_time) * simulation->rate, backlog);
+		}
+		simulation->last_time = time;
+
+		int stepped = 0;
+		while (!simulation->pause && (simulation->rate != 0 ? simulation->accumulator >= frequency : !stepped)) {
+			// A recording is played instead of stepping, pausing at its end
+			Uint64 step_start = SDL_GetPerformanceCounter();
+			if (simulation->player != NULL) {
+				simulation->pause = Player_step(simulation->player, cells_grid) != 1;
+			}
+			else {
+				CellsGrid_step(cells_grid);
+				simulation->totals.cells += (Uint64)cells_grid->stepped_tiles * CELLS_WORD_BITS * CELLS_TILE_ROWS;
+			}
+			simulation->totals.step_time += SDL_GetPerformanceCounter() - step_start;
+			++simulation->totals.generations;
+			if (simulation->history != NULL) {
+				History_record_step(simulation->history, cells_grid);
+			}
+			if (simulation->recorder != NULL) {
+				Recorder_record(simulation->recorder, cells_grid);
+			}
+
+			if (simulation->rate != 0) {
+				simulation->accumulator -= frequency;
+			}
+			stepped = 1;
+			if (SDL_GetPerformanceCounter() - time >= frequency / SIMULATION_BATCH_DIVISOR) {
+				break;
+			}
+		}
+		if (simulation->pause) {
+			simulation->accumulator = 0;
+		}
+		changed |= stepped || simulation->unpublished;
+
+		// Changes the reader kept the only snapshot locked for are published on a later loop
+		if (changed) {
+			simulation->unpublished = publish(simulation) != 0;
+			if (simulation->unpublished && !stepped) {
+				SDL_Delay(1);
+			}
+		}
+		else if (simulation->pause) {
+			// Nothing happens until a command comes, the ones that came meanwhile were just run
+			SDL_SemWait(simulation->commands_sent);
+			while (SDL_SemTryWait(simulation->commands_sent) == 0) {
+			}
+		}
+		else {
+			SDL_Delay(1);
+		}
+	}
+
+	return 0;
+}
+
+Simulation* Simulation_create(CellsGrid* cells_grid, Player* player, History* history, Recorder* recorder) {
+	Simulation* simulation = calloc(1, sizeof(Simulation));
+	if (simulation == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for simulation\n");
+		return NULL;
+	}
+
+	simulation->cells_grid = cells_grid;
+	simulation->player = player;
+	simulation->history = history;
+	simulation->recorder = recorder;
+	simulation->pause = 1;
+	simulation->rate = SIMULATION_DEFAULT_RATE;
+	simulation->last_time = SDL_GetPerformanceCounter();
+	simulation->wake_event = SDL_RegisterEvents(1);
+
+	simulation->commands_sent = SDL_CreateSemaphore(0);
+	if (simulation->commands_sent == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create simulation semaphore: %s\n", SDL_GetError());
+		Simulation_delete(simulation);
+		return NULL;
+	}
+
+	// Big boards share one snapshot between the thread and the reader
+	if (snapshot_size(cells_grid) > SIMULATION_SNAPSHOT_LIMIT) {
+		simulation->lock = SDL_CreateMutex();
+		if (simulation->lock == NULL) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create simulation snapshot lock: %s\n", SDL_GetError());
+			Simulation_delete(simulation);
+			return NULL;
+		}
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Board is too big for triple buffering, the view may fall behind the simulation\n");
+	}
+
+	for (int i = 0; i < (simulation->lock != NULL ? 1 : 3); ++i) {
+		simulation->snapshots[i] = CellsGrid_create_snapshot(cells_grid);
+		if (simulation->snapshots[i] == NULL) {
+			Simulation_delete(simulation);
+			return NULL;
+		}
+	}
+	simulation->front = 0;
+	SDL_AtomicSet(&simulation->latest, simulation->lock != NULL ? 0 : 1);
+	simulation->back = simulation->lock != NULL ? 0 : 2;
+
+	simulation->thread = SDL_CreateThread(simulate, "simulation", simulation);
+	if (simulation->thread == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start simulation thread: %s\n", SDL_GetError());
+		Simulation_delete(simulation);
+		return NULL;
+	}
+
+	return simulation;
+}
+
+void Simulation_delete(Simulation* simulation) {
+	if (simulation->thread != NULL) {
+		SDL_AtomicSet(&simulation->quit, 1);
+		SDL_SemPost(simulation->commands_sent);
+		SDL_WaitThread(simulation->thread, NULL);
+	}
+	if (simulation->commands_sent != NULL) {
+		SDL_DestroySemaphore(simulation->commands_sent);
+	}
+	if (simulation->lock != NULL) {
+		if (simulation->locked) {
+			SDL_UnlockMutex(simulation->lock);
+		}
+		SDL_DestroyMutex(simulation->lock);
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		if (simulation->snapshots[i] != NULL) {
+			CellsGrid_delete(simulation->snapshots[i]);
+		}
+	}
+	if (simulation->clipboard != NULL) {
+		CellsRegion_delete(simulation->clipboard);
+	}
+	free(simulation);
+}
+
+int Simulation_send(Simulation* simulation, const SimulationCommand* command) {
+	int head = SDL_AtomicGet(&simulation->head), next = (head + 1) % SIMULATION_QUEUE_LENGTH;
+	if (next == SDL_AtomicGet(&simulation->tail)) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Simulation is behind, dropped a command\n");
+		return -1;
+	}
+	SDL_MemoryBarrierAcquire();
+
+	simulation->commands[head] = *command;
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&simulation->head, next);
+	SDL_SemPost(simulation->commands_sent);
+
+	return 0;
+}
+
+const CellsGrid* Simulation_latest(Simulation* simulation) {
+	if (simulation->lock != NULL) {
+		if (!simulation->locked) {
+			if (SDL_TryLockMutex(simulation->lock) != 0) {
+				return NULL;
+			}
+			simulation->locked = 1;
+			SDL_AtomicSet(&simulation->latest, 0);
+			simulation->front_stats = simulation->stats[0];
+		}
+	}
+	else if (!simulation->held && (SDL_AtomicGet(&simulation->latest) & SIMULATION_FRESH)) {
+		simulation->front = SDL_AtomicSet(&simulation->latest, simulation->front) & ~SIMULATION_FRESH;
+		SDL_MemoryBarrierAcquire();
+		simulation->front_stats = simulation->stats[simulation->front];
+	}
+
+	return simulation->snapshots[simulation->front];
+}
+
+void Simulation_release(Simulation* simulation) {
+	if (simulation->locked && !simulation->held) {
+		SDL_UnlockMutex(simulation->lock);
+		simulation->locked = 0;
+	}
+}
+
+void Simulation_hold(Simulation* simulation, int hold) {
+	simulation->held = hold;
+}
+
+void Simulation_wait(Simulation* simulation, Uint32 timeout) {
+	// Either the thread sees the flag after publishing and wakes the queue, or the generation is seen here.
+	// A held reader can't take it, so it waits regardless
+	SDL_AtomicSet(&simulation->waiting, 1);
+	if (simulation->held || (SDL_AtomicGet(&simulation->latest) & SIMULATION_FRESH) == 0) {
+		SDL_WaitEventTimeout(NULL, timeout);
+	}
+	SDL_AtomicSet(&simulation->waiting, 0);
+}
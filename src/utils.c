@@ -2,7 +2,7 @@
 
 float g_scale;
 
-int init_SDL(SDL_Window** window, SDL_Renderer** renderer, FPSmanager* fps_manager, int window_width, int window_height) {
+int init_SDL(SDL_Window** window, SDL_Renderer** renderer, int* refresh_rate, int* vsync, int window_width, int window_height) {
 	// Initialize SDL
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s\n", SDL_GetError());
@@ -21,9 +21,6 @@ int init_SDL(SDL_Window** window, SDL_Renderer** renderer, FPSmanager* fps_manag
 		return -1;
 	}
 
-	// Initialize framerate manager
-	SDL_initFramerate(fps_manager);
-
 	// Get index of a display associated with SDL window
 	int displayIndex = SDL_GetWindowDisplayIndex(*window);
 	if (displayIndex != 0) {
@@ -46,15 +43,7 @@ int init_SDL(SDL_Window** window, SDL_Renderer** renderer, FPSmanager* fps_manag
 		return -1;
 	}
 
-	// Set target framerate for framerate manager
-	if (SDL_setFramerate(fps_manager, displayMode.refresh_rate) != 0) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to set target framerate for framerate manager\n");
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Framerate manager initialization error", "Failed to set target framerate for framerate manager", *window);
-
-		SDL_DestroyWindow(*window);
-		SDL_Quit();
-		return -1;
-	}
+	*refresh_rate = displayMode.refresh_rate;
 
 	// Create renderer
 	*renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_PRESENTVSYNC);
@@ -67,6 +56,10 @@ int init_SDL(SDL_Window** window, SDL_Renderer** renderer, FPSmanager* fps_manag
 		return -1;
 	}
 
+	// Vsync isn't guaranteed, frames are paced by hand without it
+	SDL_RendererInfo rendererInfo;
+	*vsync = SDL_GetRendererInfo(*renderer, &rendererInfo) == 0 && (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+
 	// Set global scaling factor
 	g_scale = displayMode.w == 1920 ? displayMode.w / 1920.0f : displayMode.h / 1080.0f;
 
@@ -104,3 +97,8 @@ void clear_screen(SDL_Renderer* renderer, Uint32 color) {
 		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to clear the screen: %s\n", SDL_GetError());
 	}
 }
+
+int has_extension(const char* path, const char* extension) {
+	size_t path_length = SDL_strlen(path), extension_length = SDL_strlen(extension);
+	return path_length >= extension_length && SDL_strcasecmp(path + path_length - extension_length, extension) == 0;
+}
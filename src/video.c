@@ -0,0 +1,316 @@
+#include "../include/video.h"
+#include "../include/utils.h"
+
+static int queue_init(VideoQueue* queue) {
+	queue->lock = SDL_CreateMutex();
+	queue->changed = SDL_CreateCond();
+	return queue->lock != NULL && queue->changed != NULL ? 0 : -1;
+}
+
+static void queue_destroy(VideoQueue* queue) {
+	SDL_DestroyCond(queue->changed);
+	SDL_DestroyMutex(queue->lock);
+}
+
+// Producer side: slot to fill next, waits while every slot is taken
+static size_t queue_reserve(VideoQueue* queue) {
+	SDL_LockMutex(queue->lock);
+	while (queue->count == VIDEO_QUEUE_LENGTH) {
+		SDL_CondWait(queue->changed, queue->lock);
+	}
+	size_t slot = (queue->first + queue->count) % VIDEO_QUEUE_LENGTH;
+	SDL_UnlockMutex(queue->lock);
+
+	return slot;
+}
+
+static void queue_push(VideoQueue* queue) {
+	SDL_LockMutex(queue->lock);
+	++queue->count;
+	SDL_CondBroadcast(queue->changed);
+	SDL_UnlockMutex(queue->lock);
+}
+
+static void queue_close(VideoQueue* queue) {
+	SDL_LockMutex(queue->lock);
+	queue->closed = 1;
+	SDL_CondBroadcast(queue->changed);
+	SDL_UnlockMutex(queue->lock);
+}
+
+// Consumer side: oldest filled slot, waits while there is none. Returns -1 once the queue is closed and empty
+static int queue_peek(VideoQueue* queue) {
+	SDL_LockMutex(queue->lock);
+	while (queue->count == 0 && !queue->closed) {
+		SDL_CondWait(queue->changed, queue->lock);
+	}
+	int slot = queue->count != 0 ? (int)queue->first : -1;
+	SDL_UnlockMutex(queue->lock);
+
+	return slot;
+}
+
+static void queue_pop(VideoQueue* queue) {
+	SDL_LockMutex(queue->lock);
+	queue->first = (queue->first + 1) % VIDEO_QUEUE_LENGTH;
+	--queue->count;
+	SDL_CondBroadcast(queue->changed);
+	SDL_UnlockMutex(queue->lock);
+}
+
+// BT.601 studio range in integers, so frames come out the same everywhere. Chroma offsets are added before
+// shifting to keep the sums positive
+static void rgb_to_yuv(const Uint8* rgb, Uint8* yuv) {
+	int r = rgb[0], g = rgb[1], b = rgb[2];
+	yuv[0] = (66 * r + 129 * g + 25 * b + 128 + (16 << 8)) >> 8;
+	yuv[1] = (-38 * r - 74 * g + 112 * b + 128 + (128 << 8)) >> 8;
+	yuv[2] = (112 * r - 94 * g - 18 * b + 128 + (128 << 8)) >> 8;
+}
+
+static inline size_t frame_width(const VideoEncoder* encoder) {
+	return encoder->width * encoder->scale;
+}
+
+static inline size_t frame_height(const VideoEncoder* encoder) {
+	return encoder->height * encoder->scale;
+}
+
+// Looks up the colors of a row of cells the way CellsGrid_get_age ages them
+static void row_colors(const VideoEncoder* encoder, const VideoSnapshot* snapshot, size_t y, const Uint8** colors) {
+	size_t words_per_row = (encoder->width + CELLS_WORD_BITS - 1) / CELLS_WORD_BITS;
+	const CellsWord* row = snapshot->cells + y * words_per_row;
+	const Uint8* ages = encoder->has_age ? snapshot->age + y * encoder->width : NULL;
+
+	for (size_t i = 0; i < words_per_row; ++i) {
+		CellsWord word = row[i];
+		size_t x0 = i * CELLS_WORD_BITS, x1 = SDL_min(x0 + CELLS_WORD_BITS, encoder->width);
+		if (ages == NULL) {
+			for (size_t x = x0; x < x1; ++x, word >>= 1) {
+				colors[x] = encoder->palette[word & 1][CELL_AGE_MAX];
+			}
+			continue;
+		}
+
+		Uint64 behind = snapshot->generation - snapshot->age_generation[y / CELLS_TILE_ROWS * words_per_row + i];
+		for (size_t x = x0; x < x1; ++x, word >>= 1) {
+			Uint64 age = ages[x] + behind;
+			colors[x] = encoder->palette[word & 1][age < CELL_AGE_MAX ? age : CELL_AGE_MAX];
+		}
+	}
+}
+
+// Every cell is a scale by scale square, so only the first pixel row of a cell row is drawn and then copied
+static void rasterise(const VideoEncoder* encoder, const VideoSnapshot* snapshot, const Uint8** colors, Uint8* frame) {
+	size_t width = frame_width(encoder), plane_size = width * frame_height(encoder);
+	unsigned int scale = encoder->scale;
+
+	for (size_t y = 0; y < encoder->height; ++y) {
+		row_colors(encoder, snapshot, y, colors);
+
+		if (encoder->is_y4m) {
+			for (int plane = 0; plane < 3; ++plane) {
+				Uint8* out = frame + plane * plane_size + y * scale * width;
+				if (scale == 1) {
+					for (size_t x = 0; x < encoder->width; ++x) {
+						out[x] = colors[x][plane];
+					}
+				}
+				else {
+					for (size_t x = 0; x < encoder->width; ++x) {
+						memset(out + x * scale, colors[x][plane], scale);
+					}
+				}
+				for (unsigned int i = 1; i < scale; ++i) {
+					memcpy(out + i * width, out, width);
+				}
+			}
+		}
+		else {
+			Uint8* out = frame + y * scale * width * 3;
+			for (size_t x = 0; x < encoder->width; ++x) {
+				for (unsigned int i = 0; i < scale; ++i) {
+					memcpy(out + (x * scale + i) * 3, colors[x], 3);
+				}
+			}
+			for (unsigned int i = 1; i < scale; ++i) {
+				memcpy(out + i * width * 3, out, width * 3);
+			}
+		}
+	}
+}
+
+static int rasterise_frames(void* data) {
+	VideoEncoder* encoder = data;
+	const Uint8** colors = malloc(sizeof(Uint8*) * encoder->width);
+
+	int snapshot;
+	while ((snapshot = queue_peek(&encoder->snapshot_queue)) >= 0) {
+		// Without the colors buffer frames are dropped, the writer notes the failure
+		if (colors != NULL) {
+			size_t frame = queue_reserve(&encoder->frame_queue);
+			rasterise(encoder, &encoder->snapshots[snapshot], colors, encoder->frames[frame]);
+			queue_push(&encoder->frame_queue);
+		}
+		queue_pop(&encoder->snapshot_queue);
+	}
+
+	if (colors == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for video rows\n");
+		encoder->failed = 1;
+	}
+	free(colors);
+	queue_close(&encoder->frame_queue);
+	return 0;
+}
+
+static int write_frames(void* data) {
+	VideoEncoder* encoder = data;
+	size_t frame_size = frame_width(encoder) * frame_height(encoder) * 3;
+	int failed = 0;
+
+	int frame;
+	while ((frame = queue_peek(&encoder->frame_queue)) >= 0) {
+		// After a failed write frames are still taken off the queue, so the other stages never wait for nothing
+		if (!failed) {
+			if (encoder->is_y4m) {
+				failed = fputs("FRAME\n", encoder->file) < 0;
+			}
+			else {
+				failed = fprintf(encoder->file, "P6\n%zu %zu\n255\n", frame_width(encoder), frame_height(encoder)) < 0;
+			}
+			failed = failed || fwrite(encoder->frames[frame], 1, frame_size, encoder->file) != frame_size;
+		}
+		queue_pop(&encoder->frame_queue);
+	}
+
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write video frame\n");
+	}
+	encoder->failed |= failed;
+	return 0;
+}
+
+static void delete_encoder(VideoEncoder* encoder) {
+	if (encoder->file != NULL) {
+		fclose(encoder->file);
+	}
+	for (int i = 0; i < VIDEO_QUEUE_LENGTH; ++i) {
+		free(encoder->snapshots[i].cells);
+		free(encoder->snapshots[i].age);
+		free(encoder->snapshots[i].age_generation);
+		free(encoder->frames[i]);
+	}
+	queue_destroy(&encoder->snapshot_queue);
+	queue_destroy(&encoder->frame_queue);
+	free(encoder);
+}
+
+VideoEncoder* VideoEncoder_create(const CellsGrid* cells_grid, const Gradient* gradient, unsigned int scale, unsigned int fps, const char* path) {
+	VideoEncoder* encoder = calloc(1, sizeof(VideoEncoder));
+	if (encoder == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for video encoder\n");
+		return NULL;
+	}
+
+	encoder->width = cells_grid->width;
+	encoder->height = cells_grid->height;
+	encoder->scale = scale;
+	encoder->has_age = cells_grid->age != NULL;
+	encoder->is_y4m = has_extension(path, ".y4m");
+	for (int is_alive = 0; is_alive <= 1; ++is_alive) {
+		for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+			SDL_Color color = Gradient_color(gradient, is_alive, age);
+			Uint8* entry = encoder->palette[is_alive][age];
+			entry[0] = color.r;
+			entry[1] = color.g;
+			entry[2] = color.b;
+			if (encoder->is_y4m) {
+				Uint8 rgb[3] = {color.r, color.g, color.b};
+				rgb_to_yuv(rgb, entry);
+			}
+		}
+	}
+
+	size_t words = cells_grid->words_per_row * cells_grid->height;
+	size_t tiles = cells_grid->tiles_x * cells_grid->tiles_y;
+	size_t frame_size = frame_width(encoder) * frame_height(encoder) * 3;
+	int failed = queue_init(&encoder->snapshot_queue) != 0 || queue_init(&encoder->frame_queue) != 0;
+	for (int i = 0; i < VIDEO_QUEUE_LENGTH && !failed; ++i) {
+		VideoSnapshot* snapshot = &encoder->snapshots[i];
+		snapshot->cells = malloc(sizeof(CellsWord) * words);
+		if (encoder->has_age) {
+			snapshot->age = malloc(cells_grid->width * cells_grid->height);
+			snapshot->age_generation = malloc(sizeof(Uint64) * tiles);
+		}
+		encoder->frames[i] = malloc(frame_size);
+		failed = snapshot->cells == NULL || (encoder->has_age && (snapshot->age == NULL || snapshot->age_generation == NULL)) ||
+				 encoder->frames[i] == NULL;
+	}
+	if (failed) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for %zux%zu video frames\n", frame_width(encoder), frame_height(encoder));
+		delete_encoder(encoder);
+		return NULL;
+	}
+
+	encoder->file = fopen(path, "wb");
+	if (encoder->file == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open video '%s'\n", path);
+		delete_encoder(encoder);
+		return NULL;
+	}
+	if (encoder->is_y4m && fprintf(encoder->file, "YUV4MPEG2 W%zu H%zu F%u:1 Ip A1:1 C444\n", frame_width(encoder), frame_height(encoder), fps) < 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write video '%s'\n", path);
+		delete_encoder(encoder);
+		return NULL;
+	}
+
+	encoder->write_thread = SDL_CreateThread(write_frames, "video writer", encoder);
+	if (encoder->write_thread != NULL) {
+		encoder->raster_thread = SDL_CreateThread(rasterise_frames, "video rasteriser", encoder);
+	}
+	if (encoder->raster_thread == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start video threads: %s\n", SDL_GetError());
+		if (encoder->write_thread != NULL) {
+			queue_close(&encoder->frame_queue);
+			SDL_WaitThread(encoder->write_thread, NULL);
+		}
+		delete_encoder(encoder);
+		return NULL;
+	}
+
+	return encoder;
+}
+
+int VideoEncoder_add_frame(VideoEncoder* encoder, const CellsGrid* cells_grid) {
+	if (cells_grid->width != encoder->width || cells_grid->height != encoder->height || (cells_grid->age != NULL) != encoder->has_age) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Grid doesn't match the video\n");
+		return -1;
+	}
+
+	VideoSnapshot* snapshot = &encoder->snapshots[queue_reserve(&encoder->snapshot_queue)];
+	memcpy(snapshot->cells, cells_grid->cells, sizeof(CellsWord) * cells_grid->words_per_row * cells_grid->height);
+	if (encoder->has_age) {
+		memcpy(snapshot->age, cells_grid->age, cells_grid->width * cells_grid->height);
+		memcpy(snapshot->age_generation, cells_grid->age_generation, sizeof(Uint64) * cells_grid->tiles_x * cells_grid->tiles_y);
+	}
+	snapshot->generation = cells_grid->generation;
+	queue_push(&encoder->snapshot_queue);
+
+	return 0;
+}
+
+int VideoEncoder_finish(VideoEncoder* encoder) {
+	queue_close(&encoder->snapshot_queue);
+	SDL_WaitThread(encoder->raster_thread, NULL);
+	SDL_WaitThread(encoder->write_thread, NULL);
+
+	int failed = encoder->failed;
+	if (fclose(encoder->file) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write video\n");
+		failed = 1;
+	}
+	encoder->file = NULL;
+	delete_encoder(encoder);
+
+	return failed ? -1 : 0;
+}
@@ -0,0 +1,517 @@
+#include "../include/view.h"
+
+// Translucent so both dead and alive cells show through
+static const Uint32 MESH_COLOR = 0x60a0a0a0;
+
+static inline int mesh_tile_pixels(unsigned int pixels_per_cell) {
+	return (VIEW_MESH_TILE_PIXELS + pixels_per_cell - 1) / pixels_per_cell * pixels_per_cell;
+}
+
+// Tile of cells with a line along the top and left edge of each, it repeats seamlessly
+static SDL_Texture* create_mesh_tile(SDL_Renderer* renderer, unsigned int pixels_per_cell) {
+	int size = mesh_tile_pixels(pixels_per_cell);
+	Uint32* pixels = malloc(sizeof(Uint32) * size * size);
+	if (pixels == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for mesh tile\n");
+		return NULL;
+	}
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			pixels[y * size + x] = x % pixels_per_cell == 0 || y % pixels_per_cell == 0 ? MESH_COLOR : 0;
+		}
+	}
+
+	SDL_Texture* tile = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, size, size);
+	if (tile == NULL || SDL_UpdateTexture(tile, NULL, pixels, size * sizeof(Uint32)) != 0 || SDL_SetTextureBlendMode(tile, SDL_BLENDMODE_BLEND) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %dx%d mesh tile: %s\n", size, size, SDL_GetError());
+		if (tile != NULL) {
+			SDL_DestroyTexture(tile);
+		}
+		tile = NULL;
+	}
+	free(pixels);
+
+	return tile;
+}
+
+// Hot tiles go from a faint yellow to an opaque-ish red
+static void build_heat_colors(CellsView* view) {
+	for (Uint32 i = 0; i < 256; ++i) {
+		Uint32 alpha = i * 3 / 4, green = 255 - i * 3 / 4;
+		view->heat_colors[i] = alpha << 24 | 0xff0000 | green << 8;
+	}
+}
+
+CellsView* CellsView_create(SDL_Renderer* renderer, const CellsGrid* cells_grid, const SDL_Rect* viewport) {
+	CellsView* view = calloc(1, sizeof(CellsView));
+	if (view == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells view\n");
+		return NULL;
+	}
+
+	view->pixels_per_cell = SDL_min(cells_grid->cell_size, VIEW_MAX_PIXELS_PER_CELL);
+	view->cells_per_pixel = 1;
+
+	// One texel per pixel, with a tile of slack on each side for the texture to stay tile aligned
+	view->texture_width = viewport->w + 2 * CELLS_WORD_BITS;
+	view->texture_height = viewport->h + 2 * CELLS_TILE_ROWS;
+	view->pixels = malloc(sizeof(Uint32) * view->texture_width * view->texture_height);
+	view->settled = calloc((view->texture_width / CELLS_WORD_BITS) * (view->texture_height / CELLS_TILE_ROWS), sizeof(Uint64));
+
+	// Texels of the heat overlay are never narrower than VIEW_MIN_HEAT_PIXELS, plus one of slack on each side
+	view->heat_texture_width = viewport->w / VIEW_MIN_HEAT_PIXELS + 2;
+	view->heat_texture_height = viewport->h / VIEW_MIN_HEAT_PIXELS + 2;
+	view->heat_pixels = malloc(sizeof(Uint32) * view->heat_texture_width * view->heat_texture_height);
+	if (view->pixels == NULL || view->settled == NULL || view->heat_pixels == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate memory for cells view\n");
+		CellsView_delete(view);
+		return NULL;
+	}
+
+	view->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, view->texture_width, view->texture_height);
+	if (view->texture == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %dx%d cells texture: %s\n", view->texture_width, view->texture_height, SDL_GetError());
+		CellsView_delete(view);
+		return NULL;
+	}
+	if (SDL_SetTextureScaleMode(view->texture, SDL_ScaleModeNearest) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to set scale mode of cells texture: %s\n", SDL_GetError());
+	}
+
+	view->heat_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, view->heat_texture_width, view->heat_texture_height);
+	if (view->heat_texture == NULL || SDL_SetTextureBlendMode(view->heat_texture, SDL_BLENDMODE_BLEND) != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %dx%d heat texture: %s\n", view->heat_texture_width, view->heat_texture_height, SDL_GetError());
+		CellsView_delete(view);
+		return NULL;
+	}
+	if (SDL_SetTextureScaleMode(view->heat_texture, SDL_ScaleModeNearest) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to set scale mode of heat texture: %s\n", SDL_GetError());
+	}
+	build_heat_colors(view);
+
+	// Zooming doubles and halves (rounding down) the pixels per cell, so every zoom reachable from the starting one
+	// is some halving of it doubled some number of times
+	for (unsigned int halved = view->pixels_per_cell; halved > 0; halved /= 2) {
+		for (unsigned int pixels_per_cell = halved; pixels_per_cell <= VIEW_MAX_PIXELS_PER_CELL; pixels_per_cell *= 2) {
+			if (pixels_per_cell < VIEW_MIN_MESH_PIXELS_PER_CELL || view->mesh_tiles[pixels_per_cell] != NULL) {
+				continue;
+			}
+			view->mesh_tiles[pixels_per_cell] = create_mesh_tile(renderer, pixels_per_cell);
+			if (view->mesh_tiles[pixels_per_cell] == NULL) {
+				CellsView_delete(view);
+				return NULL;
+			}
+		}
+	}
+
+	return view;
+}
+
+void CellsView_delete(CellsView* view) {
+	if (view->texture != NULL) {
+		SDL_DestroyTexture(view->texture);
+	}
+	if (view->heat_texture != NULL) {
+		SDL_DestroyTexture(view->heat_texture);
+	}
+	for (int i = 0; i <= VIEW_MAX_PIXELS_PER_CELL; ++i) {
+		if (view->mesh_tiles[i] != NULL) {
+			SDL_DestroyTexture(view->mesh_tiles[i]);
+		}
+	}
+	if (view->density != NULL) {
+		DensityPyramid_delete(view->density);
+	}
+	free(view->pixels);
+	free(view->settled);
+	free(view->heat_pixels);
+	free(view);
+}
+
+// Size of the whole board in pixels at the current zoom
+static inline size_t board_pixels(const CellsView* view, size_t cells) {
+	return (cells + view->cells_per_pixel - 1) / view->cells_per_pixel * view->pixels_per_cell;
+}
+
+static void clamp_camera(CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport) {
+	size_t width = board_pixels(view, cells_grid->width), height = board_pixels(view, cells_grid->height);
+	view->x = SDL_min(view->x, width > (size_t)viewport->w ? width - viewport->w : 0);
+	view->y = SDL_min(view->y, height > (size_t)viewport->h ? height - viewport->h : 0);
+}
+
+void CellsView_zoom(CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int steps, int x, int y) {
+	double pivot_x = (double)(view->x + x) * view->cells_per_pixel / view->pixels_per_cell;
+	double pivot_y = (double)(view->y + y) * view->cells_per_pixel / view->pixels_per_cell;
+
+	for (; steps > 0; --steps) {
+		if (view->cells_per_pixel > 1) {
+			view->cells_per_pixel /= 2;
+		}
+		else if (view->pixels_per_cell * 2 <= VIEW_MAX_PIXELS_PER_CELL) {
+			view->pixels_per_cell *= 2;
+		}
+	}
+	for (; steps < 0; ++steps) {
+		int fits = cells_grid->width <= (size_t)viewport->w * view->cells_per_pixel &&
+				   cells_grid->height <= (size_t)viewport->h * view->cells_per_pixel;
+		if (view->pixels_per_cell > 1) {
+			view->pixels_per_cell /= 2;
+		}
+		else if (view->cells_per_pixel < VIEW_MAX_CELLS_PER_PIXEL && !fits) {
+			view->cells_per_pixel *= 2;
+		}
+	}
+	if (view->cells_per_pixel >= DENSITY_BASE_BLOCK && view->density == NULL) {
+		view->density = DensityPyramid_create(cells_grid);
+	}
+
+	view->x = SDL_max(0.0, pivot_x * view->pixels_per_cell / view->cells_per_pixel - x);
+	view->y = SDL_max(0.0, pivot_y * view->pixels_per_cell / view->cells_per_pixel - y);
+	clamp_camera(view, cells_grid, viewport);
+}
+
+void CellsView_pan(CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int dx, int dy) {
+	view->x = dx > 0 && (size_t)dx > view->x ? 0 : view->x - dx;
+	view->y = dy > 0 && (size_t)dy > view->y ? 0 : view->y - dy;
+	clamp_camera(view, cells_grid, viewport);
+}
+
+int CellsView_cell_at(const CellsView* view, const CellsGrid* cells_grid, const SDL_Rect* viewport, int x, int y, size_t* cell_x, size_t* cell_y) {
+	if (x < 0 || y < 0 || x >= viewport->w || y >= viewport->h) {
+		return -1;
+	}
+
+	// Zoomed out, a pixel stands for the top left cell of its block
+	*cell_x = (view->x + x) / view->pixels_per_cell * view->cells_per_pixel;
+	*cell_y = (view->y + y) / view->pixels_per_cell * view->cells_per_pixel;
+	return *cell_x < cells_grid->width && *cell_y < cells_grid->height ? 0 : -1;
+}
+
+static void build_palette(CellsView* view, const Gradient* gradient) {
+	for (int is_alive = 0; is_alive <= 1; ++is_alive) {
+		for (int age = 0; age <= CELL_AGE_MAX; ++age) {
+			SDL_Color color = Gradient_color(gradient, is_alive, age);
+			view->palette[is_alive][age] = 0xff000000 | (Uint32)color.r << 16 | (Uint32)color.g << 8 | color.b;
+		}
+	}
+
+	SDL_Color dead = Gradient_color(gradient, 0, CELL_AGE_MAX), alive = Gradient_color(gradient, 1, CELL_AGE_MAX);
+	for (int shade = 0; shade < 256; ++shade) {
+		Uint32 r = dead.r + (alive.r - dead.r) * shade / 255;
+		Uint32 g = dead.g + (alive.g - dead.g) * shade / 255;
+		Uint32 b = dead.b + (alive.b - dead.b) * shade / 255;
+		view->shades[shade] = 0xff000000 | r << 16 | g << 8 | b;
+	}
+	view->gradient = gradient;
+}
+
+// Colors the texels of a tile of the grid the way CellsGrid_get_age ages cells
+static void fill_tile(CellsView* view, const CellsGrid* cells_grid, size_t tile_x, size_t tile_y) {
+	size_t x0 = tile_x * CELLS_WORD_BITS, x1 = SDL_min(x0 + CELLS_WORD_BITS, cells_grid->width);
+	size_t y0 = tile_y * CELLS_TILE_ROWS, y1 = SDL_min(y0 + CELLS_TILE_ROWS, cells_grid->height);
+	Uint64 behind = cells_grid->age != NULL ? cells_grid->generation - cells_grid->age_generation[CellsGrid_tile_index(cells_grid, x0, y0)] : 0;
+
+	for (size_t y = y0; y < y1; ++y) {
+		CellsWord word = CellsGrid_row(cells_grid, y)[tile_x];
+		Uint32* out = view->pixels + (y - view->origin_y) * view->texture_width + (x0 - view->origin_x);
+		if (cells_grid->age == NULL) {
+			for (size_t x = x0; x < x1; ++x, ++out, word >>= 1) {
+				*out = view->palette[word & 1][CELL_AGE_MAX];
+			}
+			continue;
+		}
+
+		const Uint8* ages = cells_grid->age + y * cells_grid->width;
+		for (size_t x = x0; x < x1; ++x, ++out, word >>= 1) {
+			Uint64 age = ages[x] + behind;
+			*out = view->palette[word & 1][age < CELL_AGE_MAX ? age : CELL_AGE_MAX];
+		}
+	}
+}
+
+static void upload(CellsView* view, int x, int y, int width, int height) {
+	SDL_Rect rect = {x, y, width, height};
+	if (SDL_UpdateTexture(view->texture, &rect, view->pixels + (size_t)y * view->texture_width + x, view->texture_width * sizeof(Uint32)) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to update cells texture: %s\n", SDL_GetError());
+	}
+	view->uploaded_cells += (size_t)width * height;
+}
+
+// Redraws the grid tiles the texture covers that were stamped since the last frame or are still fading, all
+// of them if asked to. Runs of them in a tile row are uploaded together
+static void update_tiles(CellsView* view, const CellsGrid* cells_grid, int redraw_all) {
+	int fading = cells_grid->age != NULL && cells_grid->generation != view->generation;
+	size_t first_tile_x = view->origin_x / CELLS_WORD_BITS, first_tile_y = view->origin_y / CELLS_TILE_ROWS;
+	size_t tiles_x = SDL_min((size_t)view->texture_width / CELLS_WORD_BITS, cells_grid->tiles_x - first_tile_x);
+	size_t tiles_y = SDL_min((size_t)view->texture_height / CELLS_TILE_ROWS, cells_grid->tiles_y - first_tile_y);
+
+	for (size_t j = 0; j < tiles_y; ++j) {
+		size_t tile_y = first_tile_y + j, run_start = 0;
+		int in_run = 0;
+		for (size_t i = 0; i <= tiles_x; ++i) {
+			int dirty = 0;
+			if (i < tiles_x) {
+				Uint64* settled = &view->settled[j * (view->texture_width / CELLS_WORD_BITS) + i];
+				int stamped = cells_grid->tile_modification[tile_y * cells_grid->tiles_x + first_tile_x + i] > view->modification;
+				dirty = redraw_all || stamped || (fading && view->generation < *settled);
+				if (redraw_all || stamped) {
+					*settled = cells_grid->generation + CELL_AGE_MAX;
+				}
+				if (dirty) {
+					fill_tile(view, cells_grid, first_tile_x + i, tile_y);
+				}
+			}
+
+			if (dirty && !in_run) {
+				run_start = i;
+				in_run = 1;
+			}
+			else if (!dirty && in_run) {
+				int x0 = run_start * CELLS_WORD_BITS, y0 = j * CELLS_TILE_ROWS;
+				int x1 = SDL_min((first_tile_x + i) * CELLS_WORD_BITS, cells_grid->width) - view->origin_x;
+				int y1 = SDL_min((tile_y + 1) * CELLS_TILE_ROWS, cells_grid->height) - view->origin_y;
+				upload(view, x0, y0, x1 - x0, y1 - y0);
+				in_run = 0;
+			}
+		}
+	}
+}
+
+// log2(value) with 4 fractional bits, close enough for shading
+static inline Uint32 log2_fixed(Uint64 value) {
+	int msb = 63 - __builtin_clzll(value);
+	Uint64 fraction = msb >= 4 ? value >> (msb - 4) : value << (4 - msb);
+	return msb * 16 + (fraction & 15);
+}
+
+// Shade of a block with this many live cells out of area, on a log scale so a lone glider in a block of 65536
+// cells still shows
+static inline Uint32 shade(const CellsView* view, Uint32 count, Uint64 area) {
+	return view->shades[255 * log2_fixed((Uint64)count + 1) / log2_fixed(area + 1)];
+}
+
+// Zoomed out every texel is shaded by the live cells of its block, read from the density pyramid for large
+// blocks and counted from the words for small ones (or only their top left corner if there's no pyramid), so the
+// work only depends on the texture size. The whole texture is redrawn
+static void shade_blocks(CellsView* view, const CellsGrid* cells_grid) {
+	unsigned int block = view->cells_per_pixel;
+	int width = SDL_min((size_t)view->texture_width, (cells_grid->width - view->origin_x + block - 1) / block);
+	int height = SDL_min((size_t)view->texture_height, (cells_grid->height - view->origin_y + block - 1) / block);
+
+	int from_pyramid = block >= DENSITY_BASE_BLOCK && view->density != NULL;
+	unsigned int counted = from_pyramid ? block : SDL_min(block, (unsigned int)DENSITY_BASE_BLOCK);
+	int level = 0;
+	if (from_pyramid) {
+		DensityPyramid_update(view->density, cells_grid);
+		while ((unsigned int)DENSITY_BASE_BLOCK << level < block) {
+			++level;
+		}
+	}
+
+	for (int j = 0; j < height; ++j) {
+		size_t y = view->origin_y + (size_t)j * block;
+		Uint32* out = view->pixels + (size_t)j * view->texture_width;
+
+		// Live counts first, turned into colors in place
+		if (from_pyramid) {
+			for (int i = 0; i < width; ++i) {
+				out[i] = DensityPyramid_count(view->density, level, view->origin_x / block + i, y / block);
+			}
+		}
+		else {
+			CellsWord mask = ((CellsWord)1 << counted) - 1;
+			memset(out, 0, sizeof(Uint32) * width);
+			for (size_t row = y; row < SDL_min(y + counted, cells_grid->height); ++row) {
+				const CellsWord* words = CellsGrid_row(cells_grid, row);
+				for (int i = 0; i < width; ++i) {
+					size_t x = view->origin_x + (size_t)i * block;
+					out[i] += __builtin_popcountll(words[x / CELLS_WORD_BITS] >> (x % CELLS_WORD_BITS) & mask);
+				}
+			}
+		}
+
+		// Blocks on the grid's right and bottom edges are cut short
+		Uint64 counted_height = SDL_min((size_t)counted, cells_grid->height - y);
+		for (int i = 0; i < width - 1; ++i) {
+			out[i] = shade(view, out[i], counted_height * counted);
+		}
+		Uint64 last_width = SDL_min((size_t)counted, cells_grid->width - view->origin_x - (size_t)(width - 1) * block);
+		out[width - 1] = shade(view, out[width - 1], counted_height * last_width);
+	}
+	upload(view, 0, 0, width, height);
+}
+
+// Brings the texture up to date for texels starting at the cell (origin_x, origin_y)
+static void update_texture(CellsView* view, const CellsGrid* cells_grid, const Gradient* gradient, size_t origin_x, size_t origin_y) {
+	int has_age = cells_grid->age != NULL;
+	int redraw_all = view->gradient != gradient || (has_age && cells_grid->generation < view->generation) ||
+					 view->drawn_cells_per_pixel != view->cells_per_pixel || view->origin_x != origin_x || view->origin_y != origin_y;
+	int changed = cells_grid->modification != view->modification || (has_age && cells_grid->generation != view->generation);
+	if (view->gradient != gradient) {
+		build_palette(view, gradient);
+	}
+
+	view->uploaded_cells = 0;
+	if (!redraw_all && !changed) {
+		return;
+	}
+
+	view->origin_x = origin_x;
+	view->origin_y = origin_y;
+	view->drawn_cells_per_pixel = view->cells_per_pixel;
+	if (view->cells_per_pixel == 1) {
+		update_tiles(view, cells_grid, redraw_all);
+	}
+	else {
+		shade_blocks(view, cells_grid);
+	}
+
+	view->modification = cells_grid->modification;
+	view->generation = cells_grid->generation;
+}
+
+// Repeats the zoom's mesh tile over the visible part of the board, lined up with the cells
+static void draw_mesh_tiles(const CellsView* view, const CellsGrid* cells_grid, SDL_Renderer* renderer, const SDL_Rect* viewport) {
+	SDL_Texture* tile = view->mesh_tiles[view->pixels_per_cell];
+	if (view->cells_per_pixel > 1 || tile == NULL) {
+		return;
+	}
+
+	int size = mesh_tile_pixels(view->pixels_per_cell);
+	int width = SDL_min((size_t)viewport->w, board_pixels(view, cells_grid->width) - view->x);
+	int height = SDL_min((size_t)viewport->h, board_pixels(view, cells_grid->height) - view->y);
+	for (int y = -(int)(view->y % size); y < height; y += size) {
+		for (int x = -(int)(view->x % size); x < width; x += size) {
+			SDL_Rect source = {0, 0, SDL_min(size, width - x), SDL_min(size, height - y)};
+			SDL_Rect destination = {x, y, source.w, source.h};
+			if (SDL_RenderCopy(renderer, tile, &source, &destination) != 0) {
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render mesh: %s\n", SDL_GetError());
+				return;
+			}
+		}
+	}
+}
+
+// Tiles a side of a heat texel, the fewest that make it VIEW_MIN_HEAT_PIXELS wide. Tiles are square, so with
+// cells per pixel being a power of two the texel is a whole number of pixels
+static inline size_t heat_group(const CellsView* view) {
+	size_t group = 1;
+	while (group * CELLS_WORD_BITS * view->pixels_per_cell < (size_t)VIEW_MIN_HEAT_PIXELS * view->cells_per_pixel) {
+		group *= 2;
+	}
+	return group;
+}
+
+// Fills the heat texture with the hottest tile of each group, starting at the texel (origin_x, origin_y)
+static void fill_heat(CellsView* view, const CellsGrid* cells_grid, size_t group, size_t origin_x, size_t origin_y) {
+	size_t step = SDL_max(1, group / VIEW_HEAT_SAMPLES);
+	int width = SDL_min((size_t)view->heat_texture_width, (cells_grid->tiles_x + group - 1) / group - origin_x);
+	int height = SDL_min((size_t)view->heat_texture_height, (cells_grid->tiles_y + group - 1) / group - origin_y);
+
+	for (int y = 0; y < height; ++y) {
+		size_t tile_y0 = (origin_y + y) * group, tile_y1 = SDL_min(tile_y0 + group, cells_grid->tiles_y);
+		for (int x = 0; x < width; ++x) {
+			size_t tile_x0 = (origin_x + x) * group, tile_x1 = SDL_min(tile_x0 + group, cells_grid->tiles_x);
+			Uint16 hottest = 0;
+			for (size_t tile_y = tile_y0; tile_y < tile_y1; tile_y += step) {
+				const Uint16* heat = cells_grid->tile_heat + tile_y * cells_grid->tiles_x;
+				for (size_t tile_x = tile_x0; tile_x < tile_x1; tile_x += step) {
+					hottest = SDL_max(hottest, heat[tile_x]);
+				}
+			}
+			view->heat_pixels[y * view->heat_texture_width + x] = view->heat_colors[hottest * 255 / CELLS_HEAT_MAX];
+		}
+	}
+
+	SDL_Rect rect = {0, 0, width, height};
+	if (SDL_UpdateTexture(view->heat_texture, &rect, view->heat_pixels, view->heat_texture_width * sizeof(Uint32)) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to update heat texture: %s\n", SDL_GetError());
+	}
+}
+
+// Lays the heat of the visible tiles over the board, clipped to its edges
+static void draw_heat_overlay(CellsView* view, const CellsGrid* cells_grid, SDL_Renderer* renderer, const SDL_Rect* viewport) {
+	size_t group = heat_group(view);
+	size_t size = group * CELLS_WORD_BITS * view->pixels_per_cell / view->cells_per_pixel;  // pixels a texel side
+	size_t origin_x = view->x / size, origin_y = view->y / size;
+
+	if (!view->heat_drawn || view->heat_modification != cells_grid->modification || view->heat_group != group ||
+		view->heat_origin_x != origin_x || view->heat_origin_y != origin_y) {
+		fill_heat(view, cells_grid, group, origin_x, origin_y);
+		view->heat_drawn = 1;
+		view->heat_modification = cells_grid->modification;
+		view->heat_group = group;
+		view->heat_origin_x = origin_x;
+		view->heat_origin_y = origin_y;
+	}
+
+	SDL_Rect clip = {0, 0, SDL_min((size_t)viewport->w, board_pixels(view, cells_grid->width) - view->x),
+					 SDL_min((size_t)viewport->h, board_pixels(view, cells_grid->height) - view->y)};
+	int width = SDL_min((size_t)view->heat_texture_width, (view->x % size + clip.w + size - 1) / size);
+	int height = SDL_min((size_t)view->heat_texture_height, (view->y % size + clip.h + size - 1) / size);
+	SDL_Rect source = {0, 0, width, height};
+	SDL_Rect destination = {-(int)(view->x % size), -(int)(view->y % size), width * size, height * size};
+	if (SDL_RenderSetClipRect(renderer, &clip) != 0 || SDL_RenderCopy(renderer, view->heat_texture, &source, &destination) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render heat: %s\n", SDL_GetError());
+	}
+	SDL_RenderSetClipRect(renderer, NULL);
+}
+
+void CellsView_draw(CellsView* view, const CellsGrid* cells_grid, SDL_Renderer* renderer, const SDL_Rect* viewport, const Gradient* gradient, int draw_mesh, int draw_heat) {
+	unsigned int block = view->cells_per_pixel, scale = view->pixels_per_cell;
+
+	// First visible texel, how far into it the viewport starts and how many texels show
+	size_t texel_x = view->x / scale, texel_y = view->y / scale;
+	int offset_x = view->x % scale, offset_y = view->y % scale;
+	int visible_width = SDL_min((size_t)(offset_x + viewport->w + scale - 1) / scale, (cells_grid->width + block - 1) / block - texel_x);
+	int visible_height = SDL_min((size_t)(offset_y + viewport->h + scale - 1) / scale, (cells_grid->height + block - 1) / block - texel_y);
+
+	// Zoomed in, the texture stays tile aligned so panning within a tile redraws nothing
+	size_t origin_x = texel_x * block, origin_y = texel_y * block;
+	if (block == 1) {
+		origin_x = origin_x / CELLS_WORD_BITS * CELLS_WORD_BITS;
+		origin_y = origin_y / CELLS_TILE_ROWS * CELLS_TILE_ROWS;
+	}
+	Uint64 update_start = SDL_GetPerformanceCounter();
+	update_texture(view, cells_grid, gradient, origin_x, origin_y);
+	view->update_time = SDL_GetPerformanceCounter() - update_start;
+
+	if (SDL_RenderSetViewport(renderer, viewport) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to set viewport for cells grid: %s\n", SDL_GetError());
+	}
+
+	SDL_Rect source = {texel_x - origin_x / block, texel_y - origin_y / block, visible_width, visible_height};
+	SDL_Rect destination = {-offset_x, -offset_y, visible_width * scale, visible_height * scale};
+	if (SDL_RenderCopy(renderer, view->texture, &source, &destination) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render cells: %s\n", SDL_GetError());
+	}
+
+	if (draw_mesh) {
+		draw_mesh_tiles(view, cells_grid, renderer, viewport);
+	}
+
+	// The texture can't be trusted once heat went away, it may have been reset since
+	if (draw_heat && cells_grid->tile_heat != NULL) {
+		draw_heat_overlay(view, cells_grid, renderer, viewport);
+	}
+	else {
+		view->heat_drawn = 0;
+	}
+}
+
+// Viewport pixel the edge before a cell falls on, kept just outside the viewport when it's farther
+static inline int cell_edge_pixel(const CellsView* view, size_t cell, size_t camera, int size) {
+	long long pixel = (long long)((cell + view->cells_per_pixel - 1) / view->cells_per_pixel * view->pixels_per_cell) - (long long)camera;
+	return SDL_clamp(pixel, -1, size + 1);
+}
+
+void CellsView_draw_selection(const CellsView* view, SDL_Renderer* renderer, const SDL_Rect* viewport, size_t x, size_t y, size_t width, size_t height) {
+	int left = cell_edge_pixel(view, x, view->x, viewport->w), right = cell_edge_pixel(view, x + width, view->x, viewport->w);
+	int top = cell_edge_pixel(view, y, view->y, viewport->h), bottom = cell_edge_pixel(view, y + height, view->y, viewport->h);
+	SDL_Rect outline = {left, top, SDL_max(right - left, 1), SDL_max(bottom - top, 1)};
+
+	if (SDL_RenderSetViewport(renderer, viewport) != 0 || SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255) != 0 ||
+		SDL_RenderDrawRect(renderer, &outline) != 0) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render selection: %s\n", SDL_GetError());
+	}
+}
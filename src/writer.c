@@ -0,0 +1,113 @@
+#include "../include/writer.h"
+#include "../include/utils.h"
+#include "../include/gridfile.h"
+#include "../include/rle.h"
+#include "../include/macrocell.h"
+#include "../include/screenshot.h"
+#include "../include/checkpoint.h"
+
+// Compressed first, the board is let go of before the file is written
+static int write_checkpoint(BoardWriter* writer) {
+	Uint64 capture_start = SDL_GetPerformanceCounter();
+	Checkpoint* checkpoint = Checkpoint_capture(writer->cells_grid);
+	Uint64 generation = writer->cells_grid->generation;
+	SDL_AtomicSet(&writer->reading, 0);
+	if (checkpoint == NULL) {
+		return -1;
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Captured checkpoint of tick %llu in %.1f ms\n", (unsigned long long)generation,
+				(SDL_GetPerformanceCounter() - capture_start) * 1000.0 / SDL_GetPerformanceFrequency());
+
+	int result = Checkpoint_write(checkpoint, writer->path);
+	Checkpoint_delete(checkpoint);
+	if (result == 0) {
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote checkpoint to '%s'\n", writer->path);
+	}
+	return result;
+}
+
+static int write_pattern(BoardWriter* writer) {
+	if (!has_extension(writer->path, ".mc")) {
+		return Rle_save(writer->cells_grid, writer->path);
+	}
+
+	QuadTree* quadtree = QuadTree_from_grid(writer->cells_grid);
+	if (quadtree == NULL) {
+		return -1;
+	}
+	int result = Macrocell_save(quadtree, writer->path);
+	QuadTree_delete(quadtree);
+	return result;
+}
+
+static int write_in_background(void* data) {
+	BoardWriter* writer = data;
+
+	switch (writer->type) {
+		case BOARD_WRITE_SAVE:
+			writer->result = GridFile_save(writer->cells_grid, writer->path);
+			if (writer->result == 0) {
+				SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Saved board to '%s'\n", writer->path);
+			}
+			break;
+		case BOARD_WRITE_EXPORT:
+			writer->result = write_pattern(writer);
+			if (writer->result == 0) {
+				SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Exported board to '%s'\n", writer->path);
+			}
+			break;
+		case BOARD_WRITE_SCREENSHOT:
+			writer->result = Screenshot_save(writer->cells_grid, writer->gradient, writer->path);
+			if (writer->result == 0) {
+				SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Saved image of the board to '%s'\n", writer->path);
+			}
+			break;
+		case BOARD_WRITE_CHECKPOINT:
+			writer->result = write_checkpoint(writer);
+			break;
+	}
+
+	SDL_AtomicSet(&writer->reading, 0);
+	SDL_AtomicSet(&writer->done, 1);
+	return 0;
+}
+
+int BoardWriter_reading(BoardWriter* writer) {
+	return writer->thread != NULL && SDL_AtomicGet(&writer->reading);
+}
+
+int BoardWriter_busy(BoardWriter* writer) {
+	return writer->thread != NULL && !SDL_AtomicGet(&writer->done);
+}
+
+int BoardWriter_start(BoardWriter* writer, enum BoardWrites type, const CellsGrid* cells_grid, const Gradient* gradient, const char* path) {
+	if (BoardWriter_busy(writer)) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Still writing '%s', '%s' wasn't written\n", writer->path, path);
+		return -1;
+	}
+	BoardWriter_finish(writer);
+
+	writer->type = type;
+	writer->cells_grid = cells_grid;
+	writer->gradient = gradient;
+	SDL_strlcpy(writer->path, path, sizeof(writer->path));
+	SDL_AtomicSet(&writer->reading, 1);
+	SDL_AtomicSet(&writer->done, 0);
+	writer->thread = SDL_CreateThread(write_in_background, "board writer", writer);
+	if (writer->thread == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start board writer: %s\n", SDL_GetError());
+		return -1;
+	}
+
+	return 0;
+}
+
+int BoardWriter_finish(BoardWriter* writer) {
+	if (writer->thread == NULL) {
+		return 0;
+	}
+
+	SDL_WaitThread(writer->thread, NULL);
+	writer->thread = NULL;
+	return writer->result;
+}
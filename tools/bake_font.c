@@ -0,0 +1,97 @@
+#include "SDL_ttf.h"
+#include "../include/font.h"
+
+// Space left around glyphs, so filtering doesn't bleed neighbours in
+static const int PADDING = 1;
+
+// Blits the glyphs where the header places them and writes the header followed by the image. Returns 0 on success
+static int write_atlas(const FontAtlasHeader* header, SDL_Surface* glyphs[], int width, int height, const char* path) {
+	SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+	if (image == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create font atlas image: %s\n", SDL_GetError());
+		return -1;
+	}
+	for (int i = 0; i < FONT_ATLAS_GLYPHS; ++i) {
+		if (glyphs[i] != NULL) {
+			SDL_Rect destination = header->glyphs[i];
+			SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(glyphs[i], NULL, image, &destination);
+		}
+	}
+
+	SDL_RWops* rw = SDL_RWFromFile(path, "wb");
+	if (rw == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' for writing: %s\n", path, SDL_GetError());
+		SDL_FreeSurface(image);
+		return -1;
+	}
+	int written = SDL_RWwrite(rw, header, sizeof(FontAtlasHeader), 1) == 1 && SDL_SaveBMP_RW(image, rw, 0) == 0;
+	SDL_FreeSurface(image);
+	if (SDL_RWclose(rw) != 0 || !written) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write font atlas '%s': %s\n", path, SDL_GetError());
+		return -1;
+	}
+
+	return 0;
+}
+
+// Rasterizes the glyphs the HUD draws into a font atlas, run by the build so the game never opens the font itself
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s FONT ATLAS\n", argv[0]);
+		return 1;
+	}
+
+	if (TTF_Init() != 0) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL_ttf: %s\n", TTF_GetError());
+		return 1;
+	}
+	TTF_Font* ttf = TTF_OpenFont(argv[1], FONT_SIZE);
+	if (ttf == NULL) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open font '%s': %s\n", argv[1], TTF_GetError());
+		TTF_Quit();
+		return 1;
+	}
+
+	// Metrics the way SDL_FontCache derives them
+	FontAtlasHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FONT_ATLAS_MAGIC, sizeof(header.magic));
+	header.version = FONT_ATLAS_VERSION;
+	header.byte_order = FONT_ATLAS_BYTE_ORDER;
+	header.size = FONT_SIZE;
+	header.height = TTF_FontHeight(ttf);
+	header.ascent = TTF_FontAscent(ttf);
+	header.descent = -TTF_FontDescent(ttf);
+	header.height = SDL_max(header.height, header.ascent - header.descent);
+
+	// Glyphs are packed in rows as wide as SDL_FontCache makes its cache textures
+	SDL_Surface* glyphs[FONT_ATLAS_GLYPHS] = {0};
+	int width = header.height * 12, x = PADDING, y = PADDING;
+	SDL_Color white = {255, 255, 255, 255};
+	for (int i = 0; i < FONT_ATLAS_GLYPHS; ++i) {
+		char text[2] = {FONT_ATLAS_FIRST + i, '\0'};
+		glyphs[i] = TTF_RenderUTF8_Blended(ttf, text, white);
+		if (glyphs[i] == NULL) {
+			continue;
+		}
+
+		if (x + glyphs[i]->w + PADDING > width) {
+			x = PADDING;
+			y += header.height + PADDING;
+		}
+		header.glyphs[i] = (SDL_Rect){x, y, glyphs[i]->w, header.height};
+		x += glyphs[i]->w + PADDING;
+	}
+	TTF_CloseFont(ttf);
+	TTF_Quit();
+
+	int result = write_atlas(&header, glyphs, width, y + header.height + PADDING, argv[2]);
+	for (int i = 0; i < FONT_ATLAS_GLYPHS; ++i) {
+		if (glyphs[i] != NULL) {
+			SDL_FreeSurface(glyphs[i]);
+		}
+	}
+
+	return result != 0;
+}